@@ -0,0 +1,216 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#include "event.hpp"
+#include "pool_resource.hpp"
+#include "subscription_batch.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace rpt::churn_bench {
+
+    using clock_type = std::chrono::steady_clock;
+
+    /*
+    *   forwards to upstream and keeps the high water mark of the bytes outstanding, listener
+    *   arrays waiting in the epoch domain count until they are freed.
+    */
+    class tracking_resource : public std::pmr::memory_resource {
+    public:
+        explicit tracking_resource(std::pmr::memory_resource* upstream)
+            : upstream{ upstream }
+        {}
+
+        std::size_t peak() const { return peak_bytes.load(); }
+
+    protected:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+            auto p = upstream->allocate(bytes, alignment);
+            auto now = in_use.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+            auto seen = peak_bytes.load(std::memory_order_relaxed);
+            while (now > seen && !peak_bytes.compare_exchange_weak(seen, now, std::memory_order_relaxed)) {}
+            return p;
+        }
+
+        void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+            upstream->deallocate(p, bytes, alignment);
+            in_use.fetch_sub(bytes, std::memory_order_relaxed);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+    private:
+        std::pmr::memory_resource* upstream;
+        std::atomic<std::size_t> in_use{ 0 };
+        std::atomic<std::size_t> peak_bytes{ 0 };
+    };
+
+    /*
+    *   subscribe and unsubscribe latencies of one churning thread, in nanoseconds.
+    */
+    struct churn_samples {
+        std::vector<std::uint64_t> subscribe;
+        std::vector<std::uint64_t> unsubscribe;
+    };
+
+    double percentile(std::vector<std::uint64_t>& samples, double p) {
+        if (samples.empty())
+            return 0;
+
+        auto nth = std::next(samples.begin(), static_cast<std::ptrdiff_t>(p * static_cast<double>(samples.size() - 1)));
+        std::nth_element(samples.begin(), nth, samples.end());
+        return static_cast<double>(*nth);
+    }
+
+    double max_rss_kib() {
+#if defined(__unix__) || defined(__APPLE__)
+        auto usage = rusage{};
+        getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+        return static_cast<double>(usage.ru_maxrss) / 1024;
+#else
+        return static_cast<double>(usage.ru_maxrss);
+#endif
+#else
+        return 0;
+#endif
+    }
+
+    /*
+    *   one listener subscribed and destroyed again, paced to rate per second when rate is
+    *   not zero. the destructor is what waits for the dispatchers.
+    */
+    template<typename Callback>
+    void churn_once(rpt::event<int>& e, const Callback& cb, churn_samples& samples) {
+        auto l = std::optional<rpt::listener<Callback, int>>{};
+
+        auto start = clock_type::now();
+        l.emplace(e, cb);
+        auto subscribed = clock_type::now();
+        l.reset();
+        auto unsubscribed = clock_type::now();
+
+        samples.subscribe.push_back(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(subscribed - start).count()));
+        samples.unsubscribe.push_back(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(unsubscribed - subscribed).count()));
+    }
+
+    void pace(clock_type::time_point& next, std::int64_t rate) {
+        if (rate <= 0)
+            return;
+
+        next += std::chrono::nanoseconds{ 1'000'000'000 / rate };
+        std::this_thread::sleep_until(next);
+    }
+
+    /*
+    *   state.range(0) threads dispatch the same event nonstop while the benchmark thread and
+    *   state.range(1) - 1 others subscribe and destroy listeners, state.range(2) times a
+    *   second each or as fast as they can when it is 0. every iteration is one listener of
+    *   the benchmark thread. the event starts with background_listeners listeners.
+    */
+    void churn(benchmark::State& state) {
+        constexpr auto background_listeners = std::size_t{ 64 };
+
+        auto dispatcher_count = static_cast<std::size_t>(state.range(0));
+        auto churner_count = static_cast<std::size_t>(std::max<std::int64_t>(state.range(1), 1));
+        auto rate = state.range(2);
+
+        auto memory = tracking_resource{ &pool_resource::instance() };
+        auto e = rpt::event<int>{ rpt::event<int>::allocator_type{ &memory } };
+
+        auto callback = [](int i) { benchmark::DoNotOptimize(i); };
+        using listener_type = rpt::listener<decltype(callback), int>;
+
+        auto background = std::vector<std::unique_ptr<listener_type>>{};
+        {
+            auto batch = rpt::subscription_batch{ e };
+            for (auto i = std::size_t{ 0 }; i < background_listeners; i++)
+                background.push_back(std::make_unique<listener_type>(batch, callback));
+        }
+
+        auto stop = std::atomic<bool>{ false };
+        auto dispatches = std::atomic<std::uint64_t>{ 0 };
+
+        auto dispatchers = std::vector<std::thread>{};
+        for (auto i = std::size_t{ 0 }; i < dispatcher_count; i++) {
+            dispatchers.emplace_back([&]() {
+                auto local = std::uint64_t{ 0 };
+                while (!stop.load(std::memory_order_relaxed)) {
+                    e(1);
+                    local++;
+                }
+                dispatches.fetch_add(local);
+            });
+        }
+
+        auto samples = std::vector<churn_samples>(churner_count);
+        auto churners = std::vector<std::thread>{};
+        for (auto i = std::size_t{ 1 }; i < churner_count; i++) {
+            churners.emplace_back([&, i]() {
+                auto next = clock_type::now();
+                while (!stop.load(std::memory_order_relaxed)) {
+                    churn_once(e, callback, samples[i]);
+                    pace(next, rate);
+                }
+            });
+        }
+
+        auto start = clock_type::now();
+        auto next = start;
+        for (auto _ : state) {
+            churn_once(e, callback, samples[0]);
+            pace(next, rate);
+        }
+        auto elapsed = std::chrono::duration<double>(clock_type::now() - start).count();
+
+        stop = true;
+        for (auto& thread : dispatchers)
+            thread.join();
+        for (auto& thread : churners)
+            thread.join();
+
+        auto subscribe = std::vector<std::uint64_t>{};
+        auto unsubscribe = std::vector<std::uint64_t>{};
+        for (auto& s : samples) {
+            subscribe.insert(subscribe.end(), s.subscribe.begin(), s.subscribe.end());
+            unsubscribe.insert(unsubscribe.end(), s.unsubscribe.begin(), s.unsubscribe.end());
+        }
+
+        state.counters["dispatches/s"] = static_cast<double>(dispatches.load()) / elapsed;
+        state.counters["churn/s"] = static_cast<double>(subscribe.size()) / elapsed;
+        state.counters["sub_p50_ns"] = percentile(subscribe, 0.5);
+        state.counters["sub_p99_ns"] = percentile(subscribe, 0.99);
+        state.counters["sub_p999_ns"] = percentile(subscribe, 0.999);
+        state.counters["unsub_p50_ns"] = percentile(unsubscribe, 0.5);
+        state.counters["unsub_p99_ns"] = percentile(unsubscribe, 0.99);
+        state.counters["unsub_p999_ns"] = percentile(unsubscribe, 0.999);
+        state.counters["peak_bytes"] = benchmark::Counter(static_cast<double>(memory.peak()), benchmark::Counter::kDefaults, benchmark::Counter::kIs1024);
+        state.counters["max_rss_kib"] = max_rss_kib();
+    }
+
+    BENCHMARK(churn)
+        ->ArgNames({ "dispatchers", "churners", "rate" })
+        ->Args({ 1, 1, 0 })
+        ->Args({ 2, 2, 0 })
+        ->Args({ 4, 4, 0 })
+        ->Args({ 4, 4, 1000 })
+        ->UseRealTime();
+}
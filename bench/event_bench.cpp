@@ -0,0 +1,652 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#include "broadcast_ring.hpp"
+#include "conflating_event.hpp"
+#include "event.hpp"
+#include "keyed_event.hpp"
+#include "pool_resource.hpp"
+#include "queued_event.hpp"
+#include "static_event.hpp"
+#include "subscription_batch.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <coroutine>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <memory_resource>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace rpt::event_bench {
+
+    struct large_payload {
+        std::array<std::uint64_t, 32> values{};
+    };
+
+    /*
+    *   Per parameter type helpers, an argument to fire the event with and a listener
+    *   callback that the optimiser cannot throw away.
+    */
+    template<typename... Params>
+    struct payload;
+
+    template<>
+    struct payload<> {
+        static auto callback() { return []() { benchmark::ClobberMemory(); }; }
+
+        template<typename Event>
+        static void fire(Event& e) { e(); }
+    };
+
+    template<>
+    struct payload<int> {
+        static auto callback() { return [](int i) { benchmark::DoNotOptimize(i); }; }
+
+        template<typename Event>
+        static void fire(Event& e) { e(42); }
+    };
+
+    template<>
+    struct payload<std::string> {
+        static auto callback() { return [](std::string s) { benchmark::DoNotOptimize(s.data()); }; }
+
+        template<typename Event>
+        static void fire(Event& e) { e(std::string{ "a string long enough to avoid the small buffer" }); }
+    };
+
+    template<>
+    struct payload<large_payload> {
+        static auto callback() { return [](large_payload p) { benchmark::DoNotOptimize(p.values.data()); }; }
+
+        template<typename Event>
+        static void fire(Event& e) { e(large_payload{}); }
+    };
+
+    template<>
+    struct payload<int, std::string> {
+        static auto callback() {
+            return [](int i, std::string s) {
+                benchmark::DoNotOptimize(i);
+                benchmark::DoNotOptimize(s.data());
+            };
+        }
+
+        template<typename Event>
+        static void fire(Event& e) { e(7, std::string{ "a string long enough to avoid the small buffer" }); }
+    };
+
+    template<typename... Params>
+    using callback_type = decltype(payload<Params...>::callback());
+
+    template<typename... Params>
+    using listener_type = rpt::listener<callback_type<Params...>, Params...>;
+
+    template<typename... Params>
+    std::vector<std::unique_ptr<listener_type<Params...>>> make_listeners(rpt::event<Params...>& e, std::size_t count) {
+        auto listeners = std::vector<std::unique_ptr<listener_type<Params...>>>{};
+        listeners.reserve(count);
+        auto batch = rpt::subscription_batch{ e };
+        for (auto i = std::size_t{ 0 }; i < count; ++i)
+            listeners.push_back(std::make_unique<listener_type<Params...>>(batch, payload<Params...>::callback()));
+        return listeners;
+    }
+
+    /*
+    *   event<Params...>::operator() with state.range(0) listeners attached.
+    */
+    template<typename... Params>
+    void dispatch(benchmark::State& state) {
+        auto e = rpt::event<Params...>{};
+        auto listeners = make_listeners(e, static_cast<std::size_t>(state.range(0)));
+
+        for (auto _ : state)
+            payload<Params...>::fire(e);
+
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+        state.counters["dispatches/s"] = benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+    }
+
+    /*
+    *   event<int>::operator() fired from state.threads() threads at once on one shared
+    *   event with state.range(0) listeners attached.
+    */
+    void dispatch_threads(benchmark::State& state) {
+        static auto e = std::optional<rpt::event<int>>{};
+        static auto listeners = std::vector<std::unique_ptr<listener_type<int>>>{};
+
+        if (state.thread_index() == 0) {
+            e.emplace();
+            listeners = make_listeners(*e, static_cast<std::size_t>(state.range(0)));
+        }
+
+        for (auto _ : state)
+            payload<int>::fire(*e);
+
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+        state.counters["dispatches/s"] = benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+
+        if (state.thread_index() == 0) {
+            listeners.clear();
+            e.reset();
+        }
+    }
+
+    /*
+    *   event<int>::operator() fired from state.threads() - 1 threads while thread 0
+    *   subscribes and unsubscribes in a loop, so dispatchers regularly have a writer
+    *   waiting on them.
+    */
+    void dispatch_threads_churn(benchmark::State& state) {
+        static auto e = std::optional<rpt::event<int>>{};
+        static auto listeners = std::vector<std::unique_ptr<listener_type<int>>>{};
+
+        if (state.thread_index() == 0) {
+            e.emplace();
+            listeners = make_listeners(*e, static_cast<std::size_t>(state.range(0)));
+        }
+
+        if (state.thread_index() == 0) {
+            for (auto _ : state) {
+                auto l = e->subscribe(payload<int>::callback());
+                benchmark::DoNotOptimize(&l);
+            }
+            state.counters["churn/s"] = benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+        }
+        else {
+            for (auto _ : state)
+                payload<int>::fire(*e);
+            state.counters["dispatches/s"] = benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+        }
+
+        if (state.thread_index() == 0) {
+            listeners.clear();
+            e.reset();
+        }
+    }
+
+    /*
+    *   event<int>::post() to a pool of its own, waiting for state.range(1) posts at a time.
+    */
+    void post(benchmark::State& state) {
+        auto e = rpt::event<int>{};
+        auto listeners = make_listeners(e, static_cast<std::size_t>(state.range(0)));
+        auto pool = rpt::executor{};
+        auto in_flight = std::vector<rpt::completion>(static_cast<std::size_t>(state.range(1)));
+
+        for (auto _ : state) {
+            for (auto& done : in_flight)
+                done = e.post(pool, 1);
+            for (auto& done : in_flight)
+                done.wait();
+        }
+
+        state.SetItemsProcessed(state.iterations() * state.range(1));
+    }
+
+    /*
+    *   event<int>::fan_out() over state.range(0) listeners with the default options against
+    *   a plain dispatch of the same event.
+    */
+    void fan_out(benchmark::State& state) {
+        auto e = rpt::event<int>{};
+        auto listeners = make_listeners(e, static_cast<std::size_t>(state.range(0)));
+        auto pool = rpt::executor{};
+
+        for (auto _ : state)
+            e.fan_out(pool, rpt::fan_out_options{}, 1);
+
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    struct bench_coroutine {
+        struct promise_type {
+            bench_coroutine get_return_object() { return { std::coroutine_handle<promise_type>::from_promise(*this) }; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    bench_coroutine await_next(rpt::event<int>& e, int& out) {
+        out = std::get<0>(co_await e.next());
+    }
+
+    /*
+    *   Wait for one event<int> dispatch with co_await next().
+    */
+    void next_await(benchmark::State& state) {
+        auto e = rpt::event<int>{};
+        auto out = 0;
+
+        for (auto _ : state) {
+            auto coroutine = await_next(e, out);
+            e(1);
+            coroutine.handle.destroy();
+        }
+        benchmark::DoNotOptimize(out);
+    }
+
+    /*
+    *   The same wait with a promise set from a listener, the pattern next() replaces.
+    */
+    void next_promise(benchmark::State& state) {
+        auto e = rpt::event<int>{};
+        auto out = 0;
+
+        for (auto _ : state) {
+            auto promise = std::promise<int>{};
+            auto future = promise.get_future();
+            {
+                auto l = e.subscribe([&promise](int i) { promise.set_value(i); });
+                e(1);
+            }
+            out = future.get();
+        }
+        benchmark::DoNotOptimize(out);
+    }
+
+    /*
+    *   queued_event<int>: state.threads() producers queue while thread 0 also drains with
+    *   dispatch_pending(), 8 listeners.
+    */
+    void queued_event_mpsc(benchmark::State& state) {
+        static auto* e = static_cast<rpt::queued_event<int>*>(nullptr);
+        static auto listeners = std::vector<std::unique_ptr<listener_type<int>>>{};
+
+        if (state.thread_index() == 0) {
+            e = new rpt::queued_event<int>{ 1024, rpt::overflow_policy::drop_newest };
+            listeners = make_listeners(e->get_event(), 8);
+        }
+
+        for (auto _ : state) {
+            benchmark::DoNotOptimize((*e)(1));
+            if (state.thread_index() == 0)
+                e->dispatch_pending();
+        }
+
+        state.SetItemsProcessed(state.iterations());
+
+        if (state.thread_index() == 0) {
+            e->dispatch_pending();
+            listeners.clear();
+            delete e;
+        }
+    }
+
+    /*
+    *   conflating_event<int>: state.threads() producers update while thread 0 also
+    *   dispatches whatever is pending, 8 listeners. dispatches/s shows the conflation.
+    */
+    void conflating_event_update(benchmark::State& state) {
+        static auto* e = static_cast<rpt::conflating_event<int>*>(nullptr);
+        static auto listeners = std::vector<std::unique_ptr<listener_type<int>>>{};
+
+        if (state.thread_index() == 0) {
+            e = new rpt::conflating_event<int>{};
+            listeners = make_listeners(e->get_event(), 8);
+        }
+
+        auto dispatches = std::int64_t{ 0 };
+        for (auto _ : state) {
+            (*e)(1);
+            if (state.thread_index() == 0)
+                dispatches += e->dispatch_pending();
+        }
+
+        state.SetItemsProcessed(state.iterations());
+        state.counters["dispatches/s"] = benchmark::Counter(static_cast<double>(dispatches), benchmark::Counter::kIsRate);
+
+        if (state.thread_index() == 0) {
+            listeners.clear();
+            delete e;
+        }
+    }
+
+    /*
+    *   dispatch to state.range(0) stateless listeners that are spread over the heap and
+    *   subscribed in a random order, so the list order has nothing to do with memory order.
+    */
+    void dispatch_scattered(benchmark::State& state) {
+        auto e = rpt::event<int>{};
+        auto count = static_cast<std::size_t>(state.range(0));
+
+        auto listeners = std::vector<std::unique_ptr<listener_type<int>>>{};
+        auto padding = std::vector<std::unique_ptr<std::array<std::byte, 256>>>{};
+        auto order = std::vector<std::size_t>(count);
+        std::iota(order.begin(), order.end(), std::size_t{ 0 });
+        std::shuffle(order.begin(), order.end(), std::mt19937{ 42 });
+
+        listeners.resize(count);
+        {
+            auto batch = rpt::subscription_batch{ e };
+            for (auto i : order) {
+                listeners[i] = std::make_unique<listener_type<int>>(batch, payload<int>::callback());
+                padding.push_back(std::make_unique<std::array<std::byte, 256>>());
+            }
+        }
+
+        for (auto _ : state)
+            payload<int>::fire(e);
+
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    /*
+    *   static_event with 8 callbacks, compare with dispatch<int>/8.
+    */
+    void static_dispatch(benchmark::State& state) {
+        auto cb = payload<int>::callback();
+        auto e = rpt::make_static_event<int>(cb, cb, cb, cb, cb, cb, cb, cb);
+
+        for (auto _ : state)
+            payload<int>::fire(e);
+
+        state.SetItemsProcessed(state.iterations() * 8);
+    }
+
+    /*
+    *   state.range(0) keys with 4 listeners each, one dispatch to a single key. keyed_event
+    *   against one event<int, int> whose listeners all filter on the key.
+    */
+    void keyed_dispatch(benchmark::State& state) {
+        auto e = rpt::keyed_event<int, int>{};
+        auto listeners = std::vector<std::unique_ptr<listener_type<int>>>{};
+        for (auto key = 0; key < state.range(0); key++) {
+            for (auto&& l : make_listeners(e.get_event(key), 4))
+                listeners.push_back(std::move(l));
+        }
+
+        auto key = 0;
+        for (auto _ : state) {
+            e(key, 42);
+            key = (key + 1) % static_cast<int>(state.range(0));
+        }
+
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void keyed_dispatch_filtered(benchmark::State& state) {
+        auto e = rpt::event<int, int>{};
+        auto listeners = std::vector<std::unique_ptr<rpt::listener<std::function<void(int, int)>, int, int>>>{};
+        {
+            auto batch = rpt::subscription_batch{ e };
+            for (auto key = 0; key < state.range(0); key++) {
+                for (auto i = 0; i < 4; i++) {
+                    listeners.push_back(std::make_unique<rpt::listener<std::function<void(int, int)>, int, int>>(batch,
+                        [key](int k, int x) {
+                            if (k == key)
+                                benchmark::DoNotOptimize(x);
+                        }));
+                }
+            }
+        }
+
+        auto key = 0;
+        for (auto _ : state) {
+            e(key, 42);
+            key = (key + 1) % static_cast<int>(state.range(0));
+        }
+
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    /*
+    *   broadcast_ring<int> with 1024 slots: state.threads() producers publish to
+    *   state.range(0) consumer threads, each consumer sees every value.
+    */
+    void broadcast_ring_publish(benchmark::State& state) {
+        static auto* ring = static_cast<rpt::broadcast_ring<int>*>(nullptr);
+        static auto consumers = std::vector<rpt::broadcast_ring<int>::consumer>{};
+
+        if (state.thread_index() == 0) {
+            ring = new rpt::broadcast_ring<int>{ 1024 };
+            for (auto i = 0; i < state.range(0); i++)
+                consumers.push_back(ring->subscribe([](int x) { benchmark::DoNotOptimize(x); }));
+        }
+
+        for (auto _ : state)
+            (*ring)(1);
+
+        state.SetItemsProcessed(state.iterations());
+
+        if (state.thread_index() == 0) {
+            consumers.clear();
+            delete ring;
+        }
+    }
+
+    /*
+    *   Construction and destruction of one listener on an event that already has
+    *   state.range(0) listeners attached.
+    */
+    template<typename... Params>
+    void subscribe_unsubscribe(benchmark::State& state) {
+        auto e = rpt::event<Params...>{};
+        auto listeners = make_listeners(e, static_cast<std::size_t>(state.range(0)));
+
+        for (auto _ : state) {
+            auto l = e.subscribe(payload<Params...>::callback());
+            benchmark::DoNotOptimize(&l);
+        }
+    }
+
+    /*
+    *   subscribe_unsubscribe through a scoped_connection instead of a listener.
+    */
+    void connect_disconnect(benchmark::State& state) {
+        auto e = rpt::event<int>{};
+        auto listeners = make_listeners(e, static_cast<std::size_t>(state.range(0)));
+
+        for (auto _ : state) {
+            auto c = rpt::scoped_connection{ e.connect(payload<int>::callback()) };
+            benchmark::DoNotOptimize(&c);
+        }
+    }
+
+    /*
+    *   subscribe a one shot handler and fire it, on an event that already has
+    *   state.range(0) listeners attached.
+    */
+    void subscribe_once_fire(benchmark::State& state) {
+        auto e = rpt::event<int>{};
+        auto listeners = make_listeners(e, static_cast<std::size_t>(state.range(0)));
+
+        for (auto _ : state) {
+            e.subscribe_once(payload<int>::callback());
+            e(1);
+        }
+    }
+
+    /*
+    *   connect and disconnect while another thread keeps dispatching to a listener that
+    *   takes a few microseconds, with disconnect (state.range(0) == 0) or disconnect_async.
+    */
+    void disconnect_contended(benchmark::State& state) {
+        auto e = rpt::event<int>{};
+        auto slow = e.connect([](int) {
+            auto until = std::chrono::steady_clock::now() + std::chrono::microseconds{ 5 };
+            while (std::chrono::steady_clock::now() < until) {}
+        });
+
+        auto stop = std::atomic<bool>{ false };
+        auto dispatcher = std::thread([&]() {
+            while (!stop.load(std::memory_order_relaxed))
+                e(1);
+        });
+
+        for (auto _ : state) {
+            auto c = e.connect(payload<int>::callback());
+            if (state.range(0) == 0)
+                c.disconnect();
+            else
+                benchmark::DoNotOptimize(c.disconnect_async());
+        }
+
+        stop = true;
+        dispatcher.join();
+        slow.disconnect();
+    }
+
+    /*
+    *   Attach and then detach state.range(0) listeners one at a time.
+    */
+    void subscribe_individual(benchmark::State& state) {
+        auto e = rpt::event<int>{};
+
+        for (auto _ : state) {
+            auto listeners = std::deque<listener_type<int>>{};
+            for (auto i = 0; i < state.range(0); ++i)
+                listeners.emplace_back(e, payload<int>::callback());
+        }
+
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    /*
+    *   subscribe_unsubscribe on an event with 8 listeners, with the arrays coming from
+    *   pool_resource (state.range(0) == 1) or straight from the heap (0).
+    */
+    void subscribe_resource(benchmark::State& state) {
+        auto* resource = state.range(0)
+            ? static_cast<std::pmr::memory_resource*>(&rpt::pool_resource::instance())
+            : std::pmr::new_delete_resource();
+
+        auto e = rpt::event<int>{ rpt::event<int>::allocator_type{ resource } };
+        auto listeners = make_listeners(e, 8);
+
+        auto before = rpt::pool_resource::instance().stats();
+        for (auto _ : state) {
+            auto l = e.subscribe(payload<int>::callback());
+            benchmark::DoNotOptimize(&l);
+        }
+        auto after = rpt::pool_resource::instance().stats();
+
+        state.counters["upstream_allocations"] = static_cast<double>(after.upstream_allocations - before.upstream_allocations);
+        state.counters["bytes_reserved"] = static_cast<double>(after.bytes_reserved);
+    }
+
+    /*
+    *   Attach and then detach state.range(0) listeners with one subscription_batch each way.
+    */
+    void subscribe_batched(benchmark::State& state) {
+        auto e = rpt::event<int>{};
+
+        for (auto _ : state) {
+            auto listeners = std::deque<listener_type<int>>{};
+            {
+                auto batch = rpt::subscription_batch{ e };
+                for (auto i = 0; i < state.range(0); ++i)
+                    listeners.emplace_back(batch, payload<int>::callback());
+            }
+            auto batch = rpt::subscription_batch{ e };
+            batch.unsubscribe(listeners.begin(), listeners.end());
+        }
+
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    /*
+    *   Detach state.range(0) listeners one at a time from a large event, the tombstone path.
+    */
+    void unsubscribe_large(benchmark::State& state) {
+        auto e = rpt::event<int>{};
+
+        for (auto _ : state) {
+            state.PauseTiming();
+            auto listeners = std::deque<listener_type<int>>{};
+            {
+                auto batch = rpt::subscription_batch{ e };
+                for (auto i = 0; i < state.range(0); ++i)
+                    listeners.emplace_back(batch, payload<int>::callback());
+            }
+            state.ResumeTiming();
+
+            listeners.clear();
+        }
+
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    /*
+    *   event_base<Params...>::view_lock() on its own, the snapshot cost paid by every dispatch.
+    */
+    template<typename... Params>
+    void view_lock(benchmark::State& state) {
+        auto e = rpt::event_detail::event_base<Params...>{};
+
+        for (auto _ : state) {
+            auto view = e.view_lock();
+            benchmark::DoNotOptimize(view.begin());
+        }
+    }
+
+    void listener_counts(benchmark::internal::Benchmark* b) {
+        for (auto count : { 0, 1, 8, 64, 1024 })
+            b->Arg(count);
+    }
+
+    BENCHMARK_TEMPLATE(dispatch)->Apply(listener_counts);
+    BENCHMARK_TEMPLATE(dispatch, int)->Apply(listener_counts);
+    BENCHMARK_TEMPLATE(dispatch, std::string)->Apply(listener_counts);
+    BENCHMARK_TEMPLATE(dispatch, large_payload)->Apply(listener_counts);
+    BENCHMARK_TEMPLATE(dispatch, int, std::string)->Apply(listener_counts);
+
+    BENCHMARK(dispatch_threads)->Arg(1)->Arg(8)->ThreadRange(1, 64)->UseRealTime();
+    BENCHMARK(dispatch_threads_churn)->Arg(8)->ThreadRange(2, 64)->UseRealTime();
+
+    BENCHMARK(post)->Args({ 8, 1 })->Args({ 8, 64 })->Args({ 1024, 64 })->UseRealTime();
+
+    BENCHMARK(fan_out)->Arg(1024)->Arg(16384)->Arg(100000)->UseRealTime();
+
+    BENCHMARK(queued_event_mpsc)->ThreadRange(1, 8)->UseRealTime();
+
+    BENCHMARK(conflating_event_update)->ThreadRange(1, 8)->UseRealTime();
+
+    BENCHMARK(dispatch_scattered)->Arg(1000)->Arg(10000)->Arg(100000);
+
+    BENCHMARK(static_dispatch);
+
+    BENCHMARK(keyed_dispatch)->Arg(16)->Arg(1024)->Arg(16384);
+    BENCHMARK(keyed_dispatch_filtered)->Arg(16)->Arg(1024)->Arg(16384);
+
+    BENCHMARK(broadcast_ring_publish)->Arg(1)->Arg(4)->ThreadRange(1, 4)->UseRealTime();
+
+    BENCHMARK(next_await);
+    BENCHMARK(next_promise);
+
+    BENCHMARK_TEMPLATE(subscribe_unsubscribe)->Apply(listener_counts);
+    BENCHMARK_TEMPLATE(subscribe_unsubscribe, int)->Apply(listener_counts);
+    BENCHMARK_TEMPLATE(subscribe_unsubscribe, std::string)->Apply(listener_counts);
+
+    BENCHMARK(connect_disconnect)->Apply(listener_counts);
+    BENCHMARK(subscribe_once_fire)->Apply(listener_counts);
+    BENCHMARK(disconnect_contended)->Arg(0)->Arg(1)->UseRealTime();
+
+    BENCHMARK(subscribe_individual)->Arg(16)->Arg(256)->Arg(4096);
+    BENCHMARK(subscribe_resource)->Arg(0)->Arg(1);
+    BENCHMARK(subscribe_batched)->Arg(16)->Arg(256)->Arg(4096);
+    BENCHMARK(unsubscribe_large)->Arg(1024)->Arg(16384)->Arg(100000);
+
+    BENCHMARK_TEMPLATE(view_lock);
+    BENCHMARK_TEMPLATE(view_lock, int);
+    BENCHMARK_TEMPLATE(view_lock, std::string);
+    BENCHMARK_TEMPLATE(view_lock, large_payload);
+    BENCHMARK_TEMPLATE(view_lock, int, std::string);
+}
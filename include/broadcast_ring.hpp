@@ -0,0 +1,379 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#ifndef RPT_BROADCAST_RING
+#define RPT_BROADCAST_RING
+
+#include "detail/param_traits.hpp"
+#include "detail/waitable_atomic.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace rpt {
+
+    /*
+    *   multi producer broadcast over a preallocated power of two ring, disruptor style.
+    *
+    *   producers claim a sequence number, wait until the slot's previous lap is published
+    *   and every consumer has moved at least a lap behind it (the gating sequences), write
+    *   the slot in place and publish it in claim order. every consumer runs on a thread of
+    *   its own, reads all the slots published since it last looked as one batch and then
+    *   moves its cursor on. payloads are stored once and handed to each consumer by
+    *   reference.
+    *
+    *   a consumer only sees what is published after it subscribed. consumers must be
+    *   destroyed before the ring.
+    */
+    template<typename... Params>
+    class broadcast_ring {
+        struct consumer_state;
+
+    public:
+        using value_type = std::tuple<std::remove_cvref_t<Params>...>;
+        using sequence_type = std::int64_t;
+
+        static constexpr std::size_t cache_line_size = 64;
+
+        /*
+            a subscribed consumer thread, unsubscribes and joins the thread on destruction.
+        */
+        class consumer {
+        public:
+            consumer() = default;
+            consumer(consumer&&) = default;
+            consumer& operator=(consumer&&);
+            ~consumer();
+
+            void reset();
+
+            /*
+                last sequence this consumer has finished with.
+            */
+            sequence_type cursor() const;
+
+        private:
+            friend broadcast_ring;
+
+            consumer(broadcast_ring&, std::unique_ptr<consumer_state>);
+
+            broadcast_ring* ring{ nullptr };
+            std::unique_ptr<consumer_state> state;
+        };
+
+        explicit broadcast_ring(std::size_t capacity);
+
+        broadcast_ring(const broadcast_ring&) = delete;
+        broadcast_ring& operator=(const broadcast_ring&) = delete;
+
+        ~broadcast_ring();
+
+        /*
+            publish a value, waits while the slowest consumer is a full ring behind.
+        */
+        template<typename... Args>
+        void operator()(Args&&... args);
+
+        /*
+            start a thread that calls cb for every value published from now on.
+        */
+        template<typename Callback>
+        consumer subscribe(Callback&& cb);
+
+        std::size_t capacity() const;
+
+        /*
+            last sequence claimed by a producer.
+        */
+        sequence_type claimed() const;
+
+        /*
+            last sequence published, every sequence before it is published too.
+        */
+        sequence_type published() const;
+
+    private:
+        static constexpr int spin_count = 64;
+
+        struct alignas(cache_line_size) slot {
+            std::atomic<sequence_type> published{ -1 };
+            std::optional<value_type> value;
+        };
+
+        struct consumer_state {
+            virtual ~consumer_state() = default;
+            virtual void run(broadcast_ring&) = 0;
+
+            alignas(cache_line_size) std::atomic<sequence_type> cursor{ -1 };
+            std::atomic<bool> stopping{ false };
+            std::thread thread;
+        };
+
+        template<typename Callback>
+        struct callback_consumer : consumer_state {
+            explicit callback_consumer(Callback&& cb);
+            void run(broadcast_ring&) override;
+
+            std::remove_cvref_t<Callback> cb;
+        };
+
+        void unsubscribe(consumer_state&);
+
+        /*
+            wait until published, a slot's or last_published, has reached seq.
+        */
+        void wait_for_publish(const std::atomic<sequence_type>& published, sequence_type seq);
+
+        /*
+            wait until the slot for seq is no longer needed by any consumer.
+        */
+        void wait_for_gating(sequence_type seq);
+
+        /*
+            lowest consumer cursor, or fallback when it is lower, stored as the cached gating.
+        */
+        sequence_type update_gating(sequence_type fallback);
+
+        std::size_t mask;
+        std::unique_ptr<slot[]> slots;
+
+        alignas(cache_line_size) std::atomic<sequence_type> next_claim{ 0 };
+        alignas(cache_line_size) std::atomic<sequence_type> last_published{ -1 };
+        alignas(cache_line_size) std::atomic<sequence_type> cached_gating{ -1 };
+
+        std::mutex consumers_mutex;
+        std::vector<consumer_state*> consumers;
+
+        // bumped on publish for idle consumers and on cursor moves for gated producers.
+        event_detail::waitable_atomic<std::uint64_t> published_signal{ 0 };
+        event_detail::waitable_atomic<std::uint64_t> consumed_signal{ 0 };
+    };
+
+    template<typename... Params>
+    template<typename Callback>
+    broadcast_ring<Params...>::callback_consumer<Callback>::callback_consumer(Callback&& cb)
+        : cb{ std::forward<Callback>(cb) }
+    {}
+
+    template<typename... Params>
+    template<typename Callback>
+    void broadcast_ring<Params...>::callback_consumer<Callback>::run(broadcast_ring& ring) {
+        auto next = this->cursor.load() + 1;
+        auto spins = 0;
+
+        while (!this->stopping.load(std::memory_order_relaxed)) {
+            auto seen = ring.published_signal.load();
+
+            // take everything published contiguously from next, up to a lap.
+            auto last = next - 1;
+            while (last - next + 1 < static_cast<sequence_type>(ring.capacity())
+                && ring.slots[static_cast<std::size_t>(last + 1) & ring.mask].published.load(std::memory_order_acquire) == last + 1)
+                last++;
+
+            if (last < next) {
+                if (++spins < spin_count) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                spins = 0;
+                ring.published_signal.wait(seen);
+                continue;
+            }
+
+            for (auto seq = next; seq <= last; seq++) {
+                std::apply([this](const auto&... params) {
+                    cb(params...);
+                }, *ring.slots[static_cast<std::size_t>(seq) & ring.mask].value);
+            }
+
+            this->cursor.store(last, std::memory_order_release);
+            ring.consumed_signal++;
+            ring.consumed_signal.notify_all();
+
+            next = last + 1;
+            spins = 0;
+        }
+    }
+
+    template<typename... Params>
+    broadcast_ring<Params...>::consumer::consumer(broadcast_ring& ring, std::unique_ptr<consumer_state> state)
+        : ring{ &ring }
+        , state{ std::move(state) }
+    {}
+
+    template<typename... Params>
+    typename broadcast_ring<Params...>::consumer& broadcast_ring<Params...>::consumer::operator=(consumer&& other) {
+        reset();
+        ring = std::exchange(other.ring, nullptr);
+        state = std::move(other.state);
+        return *this;
+    }
+
+    template<typename... Params>
+    broadcast_ring<Params...>::consumer::~consumer() {
+        reset();
+    }
+
+    template<typename... Params>
+    void broadcast_ring<Params...>::consumer::reset() {
+        if (!state)
+            return;
+
+        ring->unsubscribe(*state);
+        state.reset();
+        ring = nullptr;
+    }
+
+    template<typename... Params>
+    typename broadcast_ring<Params...>::sequence_type broadcast_ring<Params...>::consumer::cursor() const {
+        return state ? state->cursor.load() : -1;
+    }
+
+    template<typename... Params>
+    broadcast_ring<Params...>::broadcast_ring(std::size_t capacity)
+        : mask{ std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1 }
+        , slots{ std::make_unique<slot[]>(mask + 1) }
+    {}
+
+    template<typename... Params>
+    broadcast_ring<Params...>::~broadcast_ring() {
+        assert(consumers.empty());
+    }
+
+    template<typename... Params>
+    template<typename... Args>
+    void broadcast_ring<Params...>::operator()(Args&&... args) {
+        auto seq = next_claim.fetch_add(1);
+        auto wrap = seq - static_cast<sequence_type>(capacity());
+        auto& s = slots[static_cast<std::size_t>(seq) & mask];
+
+        // a lagging producer may still be writing the slot a lap back.
+        wait_for_publish(s.published, wrap);
+
+        if (wrap > cached_gating.load())
+            wait_for_gating(seq);
+
+        s.value.emplace(std::forward<Args>(args)...);
+
+        // in claim order, so a slot is only published once last_published has reached it.
+        wait_for_publish(last_published, seq - 1);
+        last_published.store(seq);
+        s.published.store(seq);
+
+        published_signal++;
+        published_signal.notify_all();
+    }
+
+    template<typename... Params>
+    template<typename Callback>
+    typename broadcast_ring<Params...>::consumer broadcast_ring<Params...>::subscribe(Callback&& cb) {
+        auto state = std::unique_ptr<consumer_state>{ new callback_consumer<Callback>{ std::forward<Callback>(cb) } };
+        {
+            // start after the last published sequence, so claims still being written are
+            // seen. the gating is lowered first, a producer that finds its slot's previous
+            // lap published after this then checks the new consumer before writing.
+            auto lock = std::lock_guard{ consumers_mutex };
+            cached_gating.store(std::min(cached_gating.load(), last_published.load()));
+            state->cursor.store(last_published.load());
+            consumers.push_back(state.get());
+        }
+
+        state->thread = std::thread([this, &state = *state]() { state.run(*this); });
+        return consumer{ *this, std::move(state) };
+    }
+
+    template<typename... Params>
+    void broadcast_ring<Params...>::unsubscribe(consumer_state& state) {
+        // the consumer keeps gating producers until its thread has stopped reading.
+        state.stopping.store(true);
+        published_signal++;
+        published_signal.notify_all();
+        state.thread.join();
+
+        {
+            auto lock = std::lock_guard{ consumers_mutex };
+            consumers.erase(std::find(consumers.begin(), consumers.end(), &state));
+        }
+
+        // producers gated on this consumer can go.
+        consumed_signal++;
+        consumed_signal.notify_all();
+    }
+
+    template<typename... Params>
+    std::size_t broadcast_ring<Params...>::capacity() const {
+        return mask + 1;
+    }
+
+    template<typename... Params>
+    typename broadcast_ring<Params...>::sequence_type broadcast_ring<Params...>::claimed() const {
+        return next_claim.load() - 1;
+    }
+
+    template<typename... Params>
+    typename broadcast_ring<Params...>::sequence_type broadcast_ring<Params...>::published() const {
+        return last_published.load();
+    }
+
+    template<typename... Params>
+    void broadcast_ring<Params...>::wait_for_publish(const std::atomic<sequence_type>& published, sequence_type seq) {
+        auto spins = 0;
+
+        while (true) {
+            auto seen = published_signal.load();
+            if (published.load() >= seq)
+                return;
+
+            if (++spins < spin_count) {
+                std::this_thread::yield();
+                continue;
+            }
+            spins = 0;
+            published_signal.wait(seen);
+        }
+    }
+
+    template<typename... Params>
+    void broadcast_ring<Params...>::wait_for_gating(sequence_type seq) {
+        auto wrap = seq - static_cast<sequence_type>(capacity());
+        auto spins = 0;
+
+        while (true) {
+            auto seen = consumed_signal.load();
+            if (wrap <= update_gating(seq - 1))
+                return;
+
+            if (++spins < spin_count) {
+                std::this_thread::yield();
+                continue;
+            }
+            spins = 0;
+            consumed_signal.wait(seen);
+        }
+    }
+
+    template<typename... Params>
+    typename broadcast_ring<Params...>::sequence_type broadcast_ring<Params...>::update_gating(sequence_type fallback) {
+        // stored under the lock, so it can not overwrite the gating a new consumer lowered.
+        auto lock = std::lock_guard{ consumers_mutex };
+        auto output = fallback;
+        for (auto* state : consumers)
+            output = std::min(output, state->cursor.load(std::memory_order_acquire));
+        cached_gating.store(output);
+        return output;
+    }
+}
+
+#endif // RPT_BROADCAST_RING
@@ -0,0 +1,68 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#ifndef RPT_COMPLETION
+#define RPT_COMPLETION
+
+#include "detail/waitable_atomic.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace rpt::event_detail {
+
+    /*
+    *   shared between an asynchronous operation and the completion handed back for it,
+    *   the operation's own state derives from it so both live in one allocation.
+    */
+    struct completion_state {
+        void complete() noexcept;
+
+        waitable_atomic<std::uint32_t> finished{ 0 };
+    };
+
+    inline void completion_state::complete() noexcept {
+        finished.store(1);
+        finished.notify_all();
+    }
+}
+
+namespace rpt {
+
+    /*
+    *   handle to an asynchronous operation, it can be waited on or simply dropped.
+    *   a default constructed completion is already done.
+    */
+    class completion {
+    public:
+        completion() = default;
+        explicit completion(std::shared_ptr<const event_detail::completion_state>);
+
+        bool done() const;
+
+        /*
+            block until the operation has finished.
+        */
+        void wait() const;
+
+    private:
+        std::shared_ptr<const event_detail::completion_state> state;
+    };
+
+    inline completion::completion(std::shared_ptr<const event_detail::completion_state> state)
+        : state{ std::move(state) }
+    {}
+
+    inline bool completion::done() const {
+        return !state || state->finished.load() != 0;
+    }
+
+    inline void completion::wait() const {
+        if (state)
+            state->finished.wait(0);
+    }
+}
+
+#endif // RPT_COMPLETION
@@ -0,0 +1,155 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#ifndef RPT_CONFLATING_EVENT
+#define RPT_CONFLATING_EVENT
+
+#include "detail/waitable_atomic.hpp"
+#include "event.hpp"
+#include "listener.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace rpt {
+
+    /*
+    *   event that only keeps the newest value.
+    *
+    *   producers write into a triple buffer and publish by swapping their buffer with the
+    *   middle one, the consumer swaps the middle buffer for its own when dispatching. an
+    *   update that arrives while another is still pending replaces it, so listeners see as
+    *   many dispatches as the consumer gets through and never a backlog.
+    *
+    *   any number of producers (serialised by a spin lock around the copy), one consumer
+    *   thread calling dispatch_pending at a time.
+    */
+    template<typename... Params>
+    class conflating_event {
+    public:
+        using value_type = std::tuple<std::remove_cvref_t<Params>...>;
+
+        static constexpr std::size_t cache_line_size = 64;
+
+        conflating_event() = default;
+
+        conflating_event(const conflating_event&) = delete;
+        conflating_event& operator=(const conflating_event&) = delete;
+
+        /*
+            store a new value, returns true if no update was pending before it.
+        */
+        template<typename... Args>
+        bool operator()(Args&&... args);
+
+        /*
+            dispatch the newest value if there is one the listeners have not seen,
+            returns false when there was nothing to do.
+        */
+        bool dispatch_pending();
+
+        bool pending() const;
+
+        /*
+            block until an update is pending.
+        */
+        void wait() const;
+
+        template<typename Callback>
+        listener<Callback, Params...> subscribe(Callback&&);
+
+        /*
+            the event the listeners are subscribed to, dispatching it directly skips the buffer.
+        */
+        event<Params...>& get_event();
+
+    private:
+        static constexpr std::uint32_t dirty = 4;
+        static constexpr std::uint32_t index_mask = 3;
+
+        struct alignas(cache_line_size) buffer {
+            std::optional<value_type> value;
+        };
+
+        event<Params...> target;
+        std::array<buffer, 3> buffers;
+
+        alignas(cache_line_size) std::atomic<bool> producer_lock{ false };
+        std::uint32_t back{ 0 };
+
+        alignas(cache_line_size) std::atomic<std::uint32_t> middle{ 1 };
+
+        alignas(cache_line_size) std::uint32_t front{ 2 };
+
+        // bumped each time an update becomes pending.
+        event_detail::waitable_atomic<std::uint64_t> updates{ 0 };
+    };
+
+    template<typename... Params>
+    template<typename... Args>
+    bool conflating_event<Params...>::operator()(Args&&... args) {
+        while (producer_lock.exchange(true, std::memory_order_acquire))
+            std::this_thread::yield();
+
+        buffers[back].value.emplace(std::forward<Args>(args)...);
+        auto previous = middle.exchange(back | dirty, std::memory_order_acq_rel);
+        back = previous & index_mask;
+
+        producer_lock.store(false, std::memory_order_release);
+
+        if (previous & dirty)
+            return false;
+
+        updates++;
+        updates.notify_all();
+        return true;
+    }
+
+    template<typename... Params>
+    bool conflating_event<Params...>::dispatch_pending() {
+        if (!(middle.load(std::memory_order_relaxed) & dirty))
+            return false;
+
+        front = middle.exchange(front, std::memory_order_acq_rel) & index_mask;
+
+        std::apply([this](auto&... params) {
+            target(params...);
+        }, *buffers[front].value);
+        return true;
+    }
+
+    template<typename... Params>
+    bool conflating_event<Params...>::pending() const {
+        return (middle.load() & dirty) != 0;
+    }
+
+    template<typename... Params>
+    void conflating_event<Params...>::wait() const {
+        while (true) {
+            auto seen = updates.load();
+            if (pending())
+                return;
+            updates.wait(seen);
+        }
+    }
+
+    template<typename... Params>
+    template<typename Callback>
+    listener<Callback, Params...> conflating_event<Params...>::subscribe(Callback&& cb) {
+        return target.subscribe(std::forward<Callback>(cb));
+    }
+
+    template<typename... Params>
+    event<Params...>& conflating_event<Params...>::get_event() {
+        return target;
+    }
+}
+
+#endif // RPT_CONFLATING_EVENT
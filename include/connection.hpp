@@ -0,0 +1,197 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#ifndef RPT_CONNECTION
+#define RPT_CONNECTION
+
+#include "detail/connection_state.hpp"
+#include "detail/epoch_domain.hpp"
+#include "completion.hpp"
+
+#include <memory>
+#include <utility>
+
+namespace rpt {
+
+    /*
+    *   movable handle to a subscription made with event::connect.
+    *
+    *   the callback lives in a node allocated from pool_resource, the handle itself is a
+    *   single pointer so connections can be kept by value in containers. destroying or
+    *   overwriting a connection leaves the subscription in place until the event is
+    *   destroyed, use disconnect or scoped_connection to end it earlier.
+    */
+    class connection {
+    public:
+        connection() = default;
+
+        connection(const connection&) = delete;
+        connection& operator=(const connection&) = delete;
+
+        connection(connection&&) noexcept;
+        connection& operator=(connection&&) noexcept;
+
+        ~connection();
+
+        /*
+            unsubscribe, returns once no dispatch can still call the callback. called from
+            inside a dispatch it does not wait, dispatches on other threads may still be
+            calling it.
+        */
+        void disconnect();
+
+        /*
+            unsubscribe without waiting, no dispatch calls the callback once it returns but
+            calls already underway may still be running. the completion is done once they
+            have all finished and whatever the callback refers to can be released, the wait
+            is left to the epoch domain's reclaimer thread. it is already done if the
+            connection was not connected.
+        */
+        completion disconnect_async();
+
+        /*
+            true until disconnect is called or the event is destroyed.
+        */
+        bool connected() const;
+
+        explicit operator bool() const;
+
+    private:
+        template<typename... Params>
+        friend class event;
+
+        explicit connection(event_detail::connection_state*);
+
+        void reset();
+
+        event_detail::connection_state* state{ nullptr };
+    };
+
+    /*
+    *   connection that disconnects when it is destroyed or overwritten.
+    */
+    class scoped_connection {
+    public:
+        scoped_connection() = default;
+        scoped_connection(connection&&) noexcept;
+
+        scoped_connection(scoped_connection&&) noexcept = default;
+        scoped_connection& operator=(scoped_connection&&) noexcept;
+
+        ~scoped_connection();
+
+        void disconnect();
+        completion disconnect_async();
+        bool connected() const;
+        explicit operator bool() const;
+
+        /*
+            give up the scope, the subscription is no longer ended by this object.
+        */
+        connection release();
+
+    private:
+        connection conn;
+    };
+
+    inline connection::connection(event_detail::connection_state* state)
+        : state{ state }
+    {}
+
+    inline connection::connection(connection&& other) noexcept
+        : state{ std::exchange(other.state, nullptr) }
+    {}
+
+    inline connection& connection::operator=(connection&& other) noexcept {
+        if (this != &other) {
+            reset();
+            state = std::exchange(other.state, nullptr);
+        }
+        return *this;
+    }
+
+    inline connection::~connection() {
+        reset();
+    }
+
+    inline void connection::disconnect() {
+        if (state)
+            state->disconnect();
+    }
+
+    inline completion connection::disconnect_async() {
+        if (!state || !state->unlink())
+            return completion{};
+
+        // completed by the reclaimer once the dispatches that might still call the node
+        // have finished, it keeps itself alive until then.
+        struct disconnect_state : event_detail::completion_state, event_detail::epoch_domain::deferred {
+            std::shared_ptr<disconnect_state> self;
+        };
+
+        auto done = std::make_shared<disconnect_state>();
+        done->scope = state->_scope;
+        done->listener = state->_listener;
+        done->done = [](event_detail::epoch_domain::deferred& request) {
+            auto& self = static_cast<disconnect_state&>(request);
+            self.complete();
+            self.self.reset();
+        };
+        done->self = done;
+        event_detail::epoch_domain::instance().synchronize_async(*done);
+
+        return completion{ std::move(done) };
+    }
+
+    inline bool connection::connected() const {
+        return state && state->subscribed.load();
+    }
+
+    inline connection::operator bool() const {
+        return connected();
+    }
+
+    inline void connection::reset() {
+        if (auto current = std::exchange(state, nullptr))
+            current->release();
+    }
+
+    inline scoped_connection::scoped_connection(connection&& conn) noexcept
+        : conn{ std::move(conn) }
+    {}
+
+    inline scoped_connection& scoped_connection::operator=(scoped_connection&& other) noexcept {
+        if (this != &other) {
+            conn.disconnect();
+            conn = std::move(other.conn);
+        }
+        return *this;
+    }
+
+    inline scoped_connection::~scoped_connection() {
+        conn.disconnect();
+    }
+
+    inline void scoped_connection::disconnect() {
+        conn.disconnect();
+    }
+
+    inline completion scoped_connection::disconnect_async() {
+        return conn.disconnect_async();
+    }
+
+    inline bool scoped_connection::connected() const {
+        return conn.connected();
+    }
+
+    inline scoped_connection::operator bool() const {
+        return conn.connected();
+    }
+
+    inline connection scoped_connection::release() {
+        return std::move(conn);
+    }
+}
+
+#endif // RPT_CONNECTION
@@ -5,15 +5,30 @@
 #ifndef RPT_DETAIL_ARRAY_GENERATOR
 #define RPT_DETAIL_ARRAY_GENERATOR
 
+#include "entry_traits.hpp"
+
 #include <cassert>
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
 
 namespace rpt::event_detail {
 
+    /*
+    *   builds the immutable arrays of entries an event publishes, the size and generation
+    *   are stored in the two entries before the data. entries are read and compared
+    *   through entry_traits<T>.
+    */
     template<typename T>
     struct array_generator
     {
-        static_assert(std::is_pointer_v<T>);
+        static_assert(std::is_trivially_copyable_v<T> && sizeof(T) >= sizeof(std::size_t));
+        using traits_type = entry_traits<T>;
+        using pointer = typename traits_type::pointer;
+        using value_type = std::remove_pointer_t<pointer>;
         using allocator_type = std::pmr::polymorphic_allocator<T>;
         using array_type = std::shared_ptr<T[]>;
         using array_iterator = T*;
@@ -24,12 +39,31 @@ namespace rpt::event_detail {
 
         allocator_type get_allocator() const;
 
-        array_type make_array(std::remove_pointer_t<T>&) const;
+        array_type make_array(value_type&) const;
         array_type make_array() const;
 
-        array_type copy_push_back(const array_type&, std::remove_pointer_t<T>&) const;
+        array_type copy_push_back(const array_type&, value_type&) const;
+
+        array_type copy_remove(const array_type&, value_type&) const;
+
+        /*
+            copy without the entries in removed and with added appended.
+            removed must be sorted, entries of removed that are not in the array are ignored.
+        */
+        template<typename AddRange, typename RemoveRange>
+        array_type copy_update(const array_type&, const AddRange& added, const RemoveRange& removed) const;
 
-        array_type copy_remove(const array_type&, std::remove_pointer_t<T>&) const;
+        /*
+            copy without any tombstones.
+        */
+        array_type copy_compact(const array_type&) const;
+
+        /*
+            an entry of a published array can be replaced with a tombstone (nullptr) while
+            other threads are reading it, so both sides go through atomic accesses.
+        */
+        static pointer load_entry(T&);
+        static void tombstone(T&);
 
         static std::size_t get_size(const array_type&);
         static std::uintptr_t get_generation(const array_type&);
@@ -46,9 +80,9 @@ namespace rpt::event_detail {
     }
 
     template<typename T>
-    typename array_generator<T>::array_type array_generator<T>::make_array(std::remove_pointer_t<T>& r) const {
+    typename array_generator<T>::array_type array_generator<T>::make_array(value_type& r) const {
         auto output = make_array_for_overwrite(1, 1);
-        output[2] = &r;
+        output[2] = traits_type::make(&r);
         return output;
     }
 
@@ -64,34 +98,81 @@ namespace rpt::event_detail {
     }
 
     template<typename T>
-    typename array_generator<T>::array_type array_generator<T>::copy_push_back(const typename array_generator<T>::array_type& arr, std::remove_pointer_t<T>& t) const {
+    typename array_generator<T>::array_type array_generator<T>::copy_push_back(const typename array_generator<T>::array_type& arr, value_type& t) const {
         auto size = get_size(arr) + 1;
         auto output = make_array_for_overwrite(size, get_generation(arr) + 1);
-        *std::copy_n(get_data(arr), size - 1, get_data(output)) = &t;
+        *std::copy_n(get_data(arr), size - 1, get_data(output)) = traits_type::make(&t);
         return output;
     }
 
     template<typename T>
-    typename array_generator<T>::array_type array_generator<T>::copy_remove(const typename array_generator<T>::array_type& arr, std::remove_pointer_t<T>& t) const {
+    typename array_generator<T>::array_type array_generator<T>::copy_remove(const typename array_generator<T>::array_type& arr, value_type& t) const {
         auto size = get_size(arr) - 1;
 
         auto output = make_array_for_overwrite(size, get_generation(arr) + 1);
-        std::remove_copy(get_data(arr), std::next(get_data(arr), size + 1), get_data(output), &t);
+        std::remove_copy_if(get_data(arr), std::next(get_data(arr), size + 1), get_data(output), [&t](const T& entry) {
+            return traits_type::key(entry) == &t;
+        });
+        return output;
+    }
+
+    template<typename T>
+    template<typename AddRange, typename RemoveRange>
+    typename array_generator<T>::array_type array_generator<T>::copy_update(const array_type& arr, const AddRange& added, const RemoveRange& removed) const {
+        auto first = get_data(arr);
+        auto last = std::next(first, get_size(arr));
+        auto is_removed = [&removed](const T& entry) {
+            auto key = traits_type::key(entry);
+            return key == nullptr || std::binary_search(std::begin(removed), std::end(removed), key);
+        };
+
+        auto kept = get_size(arr) - static_cast<std::size_t>(std::count_if(first, last, is_removed));
+        auto size = kept + static_cast<std::size_t>(std::size(added));
+
+        auto output = make_array_for_overwrite(size, get_generation(arr) + 1);
+        auto out = std::remove_copy_if(first, last, get_data(output), is_removed);
+        std::transform(std::begin(added), std::end(added), out, [](pointer p) {
+            return traits_type::make(p);
+        });
+        return output;
+    }
+
+    template<typename T>
+    typename array_generator<T>::array_type array_generator<T>::copy_compact(const array_type& arr) const {
+        auto first = get_data(arr);
+        auto last = std::next(first, get_size(arr));
+        auto is_tombstone = [](const T& entry) {
+            return traits_type::key(entry) == nullptr;
+        };
+        auto size = get_size(arr) - static_cast<std::size_t>(std::count_if(first, last, is_tombstone));
+
+        auto output = make_array_for_overwrite(size, get_generation(arr) + 1);
+        std::remove_copy_if(first, last, get_data(output), is_tombstone);
         return output;
     }
 
+    template<typename T>
+    typename array_generator<T>::pointer array_generator<T>::load_entry(T& entry) {
+        return std::atomic_ref<pointer>{ traits_type::key(entry) }.load(std::memory_order_relaxed);
+    }
+
+    template<typename T>
+    void array_generator<T>::tombstone(T& entry) {
+        std::atomic_ref<pointer>{ traits_type::key(entry) }.store(nullptr, std::memory_order_relaxed);
+    }
+
     template<typename T>
     std::size_t array_generator<T>::get_size(const array_type& arr) {
         assert(arr != nullptr);
 
-        return reinterpret_cast<std::size_t>(arr[0]);
+        return reinterpret_cast<const std::size_t&>(arr[0]);
     }
 
     template<typename T>
     std::uintptr_t array_generator<T>::get_generation(const array_type& arr) {
         assert(arr != nullptr);
 
-        return reinterpret_cast<std::uintptr_t>(arr[1]);
+        return reinterpret_cast<const std::uintptr_t&>(arr[1]);
     }
 
     template<typename T>
@@ -110,7 +191,7 @@ namespace rpt::event_detail {
         reinterpret_cast<std::uintptr_t&>(ptr[1]) = generation;
         return std::shared_ptr<T[]>{ ptr,
                                         [alloc = alloc](auto* p) mutable {
-                                            auto size = reinterpret_cast<std::size_t>(p[0]);
+                                            auto size = reinterpret_cast<const std::size_t&>(p[0]);
                                             alloc.deallocate(p, size + 2);
                                         },
                                         alloc };
@@ -5,15 +5,23 @@
 #ifndef RPT_DETAIL_ARRAY_VIEWER
 #define RPT_DETAIL_ARRAY_VIEWER
 
+#include "entry_traits.hpp"
+
+#include <atomic>
 #include <cassert>
+#include <iterator>
 #include <memory>
 
 namespace rpt::event_detail {
 
-template<typename T>
+    /*
+    *   iterates the listeners of a published array, entries are read through
+    *   entry_traits<Entry> and tombstones are skipped.
+    */
+    template<typename T, typename Entry = std::remove_reference_t<T>*>
     class array_viewer {
     public:
-        using entry_type = std::remove_reference_t<T>*;
+        using entry_type = Entry;
 
         struct iterator
         {
@@ -23,19 +31,29 @@ template<typename T>
             using pointer = T*;
             using reference = T&;
 
-            iterator(pointer* ptr) : ptr(ptr) {}
+            iterator(entry_type* ptr, entry_type* last) : ptr(ptr), last(last) { skip_tombstones(); }
 
             //iterator(iterator it) : ptr(it.ptr) {}
 
-            reference operator*() const { return **ptr; }
-            pointer operator->() { return (*ptr); }
-            iterator& operator++() { ptr++; return *this; }
+            reference operator*() const { return *current; }
+            pointer operator->() { return current; }
+            iterator& operator++() { ptr++; skip_tombstones(); return *this; }
             iterator operator++(int) { iterator tmp = *this; ++(*this); return tmp; }
             friend bool operator== (const iterator& a, const iterator& b) { return a.ptr == b.ptr; };
             friend bool operator!= (const iterator& a, const iterator& b) { return a.ptr != b.ptr; };
 
         private:
-            pointer* ptr;
+            // removed entries are left as nullptr until the array is compacted.
+            void skip_tombstones() {
+                for (; ptr != last; ptr++) {
+                    if ((current = std::atomic_ref<pointer>{ entry_traits<entry_type>::key(*ptr) }.load(std::memory_order_relaxed)))
+                        return;
+                }
+            }
+
+            entry_type* ptr;
+            entry_type* last;
+            pointer current{ nullptr };
         };
 
         array_viewer(std::shared_ptr<entry_type[]>&&, std::size_t);
@@ -59,31 +77,31 @@ template<typename T>
         std::size_t sz;
     };
 
-    template<typename T>
-    array_viewer<T>::array_viewer(std::shared_ptr<entry_type[]>&& arr, std::size_t size)
+    template<typename T, typename Entry>
+    array_viewer<T, Entry>::array_viewer(std::shared_ptr<entry_type[]>&& arr, std::size_t size)
         : arr{std::move(arr)}
         , sz{size}
     {}
 
-    template<typename T>
-    array_viewer<T>::array_viewer(const std::shared_ptr<entry_type[]>& arr, std::size_t size)
+    template<typename T, typename Entry>
+    array_viewer<T, Entry>::array_viewer(const std::shared_ptr<entry_type[]>& arr, std::size_t size)
         : arr{ arr }
         , sz{ size }
     {}
 
-    template<typename T>
-    typename array_viewer<T>::iterator array_viewer<T>::begin() {
-        return iterator{ arr.get() };
+    template<typename T, typename Entry>
+    typename array_viewer<T, Entry>::iterator array_viewer<T, Entry>::begin() {
+        return iterator{ arr.get(), std::next(arr.get(), sz) };
     }
 
-    template<typename T>
-    typename array_viewer<T>::iterator array_viewer<T>::end() {
-        return iterator{ std::next(arr.get(), sz) };
+    template<typename T, typename Entry>
+    typename array_viewer<T, Entry>::iterator array_viewer<T, Entry>::end() {
+        return iterator{ std::next(arr.get(), sz), std::next(arr.get(), sz) };
     }
 
-    template<typename T>
-    std::size_t array_viewer<T>::size() {
-        return sz;
+    template<typename T, typename Entry>
+    std::size_t array_viewer<T, Entry>::size() {
+        return static_cast<std::size_t>(std::distance(begin(), end()));
     }
 }
 
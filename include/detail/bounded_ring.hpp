@@ -0,0 +1,207 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#ifndef RPT_DETAIL_BOUNDED_RING
+#define RPT_DETAIL_BOUNDED_RING
+
+#include "waitable_atomic.hpp"
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <thread>
+#include <utility>
+
+namespace rpt::event_detail {
+
+    /*
+    *   bounded lock free queue over a preallocated power of two ring.
+    *
+    *   every slot carries a sequence number, pos when it is free for the producer claiming
+    *   pos and pos + 1 once the value is published. popping and replacing the newest value
+    *   take the slot by swapping its sequence for busy, so a producer evicting the oldest
+    *   value can pop alongside the consumer. nothing is allocated after construction.
+    */
+    template<typename T>
+    class bounded_ring {
+    public:
+        static constexpr std::size_t cache_line_size = 64;
+
+        explicit bounded_ring(std::size_t capacity);
+
+        bounded_ring(const bounded_ring&) = delete;
+        bounded_ring& operator=(const bounded_ring&) = delete;
+
+        ~bounded_ring();
+
+        /*
+            value is only moved from when true is returned.
+        */
+        bool try_push(T&& value);
+
+        /*
+            replace the most recently pushed value if it has not been popped yet,
+            value is only moved from when true is returned.
+        */
+        bool try_replace_newest(T&& value);
+
+        std::optional<T> try_pop();
+
+        /*
+            block until a value has been popped since popped() returned seen.
+        */
+        void wait_for_pop(std::uint64_t seen) const;
+        std::uint64_t popped() const;
+
+        std::size_t capacity() const;
+
+        /*
+            number of values waiting, only a snapshot while producers are running.
+        */
+        std::size_t size() const;
+
+    private:
+        static constexpr std::size_t busy = ~std::size_t{ 0 };
+
+        struct alignas(cache_line_size) slot {
+            T& value();
+
+            std::atomic<std::size_t> sequence;
+            alignas(T) std::byte storage[sizeof(T)];
+        };
+
+        std::size_t mask;
+        std::unique_ptr<slot[]> slots;
+
+        alignas(cache_line_size) std::atomic<std::size_t> enqueue_pos{ 0 };
+        alignas(cache_line_size) std::atomic<std::size_t> dequeue_pos{ 0 };
+        waitable_atomic<std::uint64_t> pops{ 0 };
+    };
+
+    template<typename T>
+    T& bounded_ring<T>::slot::value() {
+        return *std::launder(reinterpret_cast<T*>(storage));
+    }
+
+    template<typename T>
+    bounded_ring<T>::bounded_ring(std::size_t capacity)
+        : mask{ std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1 }
+        , slots{ std::make_unique<slot[]>(mask + 1) }
+    {
+        for (auto i = std::size_t{ 0 }; i <= mask; i++)
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    template<typename T>
+    bounded_ring<T>::~bounded_ring() {
+        for (auto pos = dequeue_pos.load(); pos != enqueue_pos.load(); pos++) {
+            auto& s = slots[pos & mask];
+            if (s.sequence.load() == pos + 1)
+                s.value().~T();
+        }
+    }
+
+    template<typename T>
+    bool bounded_ring<T>::try_push(T&& value) {
+        auto pos = enqueue_pos.load(std::memory_order_relaxed);
+        while (true) {
+            auto& s = slots[pos & mask];
+            auto seq = s.sequence.load(std::memory_order_acquire);
+
+            if (seq == pos) {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    ::new (static_cast<void*>(s.storage)) T(std::move(value));
+                    s.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+                continue;
+            }
+
+            if (seq == busy) {
+                // the value from the last lap is being popped.
+                std::this_thread::yield();
+            }
+            else if (static_cast<std::ptrdiff_t>(seq - pos) < 0) {
+                return false;
+            }
+            pos = enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    template<typename T>
+    bool bounded_ring<T>::try_replace_newest(T&& value) {
+        auto pos = enqueue_pos.load(std::memory_order_acquire) - 1;
+        auto& s = slots[pos & mask];
+
+        auto seq = pos + 1;
+        if (!s.sequence.compare_exchange_strong(seq, busy, std::memory_order_acquire, std::memory_order_relaxed))
+            return false;
+
+        s.value() = std::move(value);
+        s.sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    template<typename T>
+    std::optional<T> bounded_ring<T>::try_pop() {
+        auto pos = dequeue_pos.load(std::memory_order_relaxed);
+        while (true) {
+            auto& s = slots[pos & mask];
+            auto seq = s.sequence.load(std::memory_order_acquire);
+
+            if (seq == pos + 1) {
+                if (s.sequence.compare_exchange_weak(seq, busy, std::memory_order_acquire, std::memory_order_relaxed)) {
+                    auto output = std::optional<T>{ std::move(s.value()) };
+                    s.value().~T();
+
+                    // only the owner of the slot at dequeue_pos can move it on.
+                    dequeue_pos.store(pos + 1, std::memory_order_relaxed);
+                    s.sequence.store(pos + mask + 1, std::memory_order_release);
+
+                    pops++;
+                    pops.notify_all();
+                    return output;
+                }
+                continue;
+            }
+
+            if (seq == busy) {
+                // being popped by an evicting producer or replaced.
+                std::this_thread::yield();
+            }
+            else if (static_cast<std::ptrdiff_t>(seq - (pos + 1)) < 0) {
+                return std::nullopt;
+            }
+            pos = dequeue_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    template<typename T>
+    void bounded_ring<T>::wait_for_pop(std::uint64_t seen) const {
+        pops.wait(seen);
+    }
+
+    template<typename T>
+    std::uint64_t bounded_ring<T>::popped() const {
+        return pops.load();
+    }
+
+    template<typename T>
+    std::size_t bounded_ring<T>::capacity() const {
+        return mask + 1;
+    }
+
+    template<typename T>
+    std::size_t bounded_ring<T>::size() const {
+        auto head = dequeue_pos.load();
+        auto tail = enqueue_pos.load();
+        return tail > head ? tail - head : 0;
+    }
+}
+
+#endif // RPT_DETAIL_BOUNDED_RING
@@ -0,0 +1,110 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#ifndef RPT_DETAIL_CONNECTION_NODE
+#define RPT_DETAIL_CONNECTION_NODE
+
+#include "connection_state.hpp"
+#include "epoch_domain.hpp"
+#include "event_base.hpp"
+#include "listener_base.hpp"
+#include "param_traits.hpp"
+
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace rpt::event_detail {
+
+    /*
+    *   listener node behind a connection, allocated from a memory resource so subscribing
+    *   through a connection does not touch the global heap.
+    *
+    *   a one shot node unlinks itself before its first call, whichever dispatch turns
+    *   subscribed off makes the only call. unlinking never waits, so it is done inside the
+    *   dispatch and the node is freed by the epoch domain once the dispatch has finished.
+    */
+    template<typename Callback, typename... Params>
+    struct connection_node : listener_base<Params...>, connection_state {
+        template<typename CB>
+        connection_node(event_base<Params...>&, CB&&, std::pmr::memory_resource*, bool once);
+
+        /*
+            allocate a node from resource and subscribe it.
+        */
+        template<typename CB>
+        static connection_state* make(event_base<Params...>&, CB&&, std::pmr::memory_resource*, bool once = false);
+
+        static void call(listener_base<Params...>&, param_t<Params>...);
+        static void call_once(listener_base<Params...>&, param_t<Params>...);
+
+        event_base<Params...>& event_base_ref;
+        std::pmr::memory_resource* resource;
+        Callback cb;
+    };
+
+    template<typename Callback, typename... Params>
+    template<typename CB>
+    connection_node<Callback, Params...>::connection_node(event_base<Params...>& event_base_ref, CB&& cb, std::pmr::memory_resource* resource, bool once)
+        : listener_base<Params...>{
+            once ? &call_once : &call,
+            [](listener_base<Params...>& base) {
+                // the event is going away, it has no list left to unlink the node from.
+                auto& self = static_cast<connection_node&>(base);
+                if (!self.subscribed.exchange(false))
+                    return false;
+
+                self.release();
+                return true;
+            } }
+        , connection_state{
+            {},
+            [](connection_state& state) {
+                auto& self = static_cast<connection_node&>(state);
+                self.event_base_ref.unlink(self);
+            },
+            [](connection_state& state) {
+                auto& self = static_cast<connection_node&>(state);
+                self.event_base_ref.wait_for_unlinked(self);
+            },
+            [](connection_state& state) {
+                auto& self = static_cast<connection_node&>(state);
+                auto* resource = self.resource;
+                self.~connection_node();
+                resource->deallocate(&self, sizeof(connection_node), alignof(connection_node));
+            } }
+        , event_base_ref{ event_base_ref }
+        , resource{ resource }
+        , cb{ std::forward<CB>(cb) }
+    {
+        _scope = &event_base_ref;
+        _listener = static_cast<listener_base<Params...>*>(this);
+    }
+
+    template<typename Callback, typename... Params>
+    void connection_node<Callback, Params...>::call(listener_base<Params...>& base, param_t<Params>... params) {
+        auto& self = static_cast<connection_node&>(base);
+        if (self.subscribed.load())
+            self.cb(params...);
+    }
+
+    template<typename Callback, typename... Params>
+    void connection_node<Callback, Params...>::call_once(listener_base<Params...>& base, param_t<Params>... params) {
+        auto& self = static_cast<connection_node&>(base);
+        if (self.unlink())
+            self.cb(params...);
+    }
+
+    template<typename Callback, typename... Params>
+    template<typename CB>
+    connection_state* connection_node<Callback, Params...>::make(event_base<Params...>& event_base_ref, CB&& cb, std::pmr::memory_resource* resource, bool once) {
+        auto* memory = resource->allocate(sizeof(connection_node), alignof(connection_node));
+        auto* node = ::new (memory) connection_node(event_base_ref, std::forward<CB>(cb), resource, once);
+        event_base_ref.subscribe(*node);
+        return node;
+    }
+}
+
+#endif // RPT_DETAIL_CONNECTION_NODE
@@ -0,0 +1,85 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#ifndef RPT_DETAIL_CONNECTION_STATE
+#define RPT_DETAIL_CONNECTION_STATE
+
+#include "epoch_domain.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+namespace rpt::event_detail {
+
+    /*
+    *   the part of a connection's listener node that does not depend on the event's
+    *   parameters.
+    *
+    *   the node is owned twice, by the event while it is subscribed and by the handle. whoever
+    *   turns subscribed off unlinks it, the last owner to let go retires it to the
+    *   epoch domain as a dispatch may still be reading it. dispatches check subscribed
+    *   before calling the callback, so once it is off the callback is not started again.
+    */
+    struct connection_state : epoch_domain::retired {
+        using unlink_type = void(*)(connection_state&);
+        using wait_type = void(*)(connection_state&);
+        using destroy_type = void(*)(connection_state&);
+
+        /*
+            unlink and wait for the dispatches that may still be calling the node.
+            returns false if the event had already let go of the node.
+        */
+        bool disconnect();
+
+        /*
+            take the node out of its event if it is still subscribed and drop the event's
+            ownership without waiting, returns false if the event had already let go of it.
+        */
+        bool unlink();
+
+        void release();
+
+        unlink_type _unlink;
+        wait_type _wait;
+        destroy_type _destroy;
+
+        // the event and the address dispatches call the node through, for waits that
+        // must not touch either.
+        const void* _scope{ nullptr };
+        const void* _listener{ nullptr };
+
+        std::atomic<bool> subscribed{ true };
+        std::atomic<std::uint32_t> owners{ 2 };
+    };
+
+    inline bool connection_state::disconnect() {
+        if (!unlink())
+            return false;
+
+        _wait(*this);
+        return true;
+    }
+
+    inline bool connection_state::unlink() {
+        if (!subscribed.exchange(false))
+            return false;
+
+        _unlink(*this);
+        release();
+        return true;
+    }
+
+    inline void connection_state::release() {
+        if (owners.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return;
+
+        deleter = [](epoch_domain::retired& r) {
+            auto& state = static_cast<connection_state&>(r);
+            state._destroy(state);
+        };
+        epoch_domain::instance().retire(*this);
+    }
+}
+
+#endif // RPT_DETAIL_CONNECTION_STATE
@@ -0,0 +1,31 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#ifndef RPT_DETAIL_ENTRY_TRAITS
+#define RPT_DETAIL_ENTRY_TRAITS
+
+#include <type_traits>
+
+namespace rpt::event_detail {
+
+    /*
+    *   how array_generator and array_viewer get at the entries they store.
+    *
+    *   an entry is keyed by a pointer, which is what entries are compared and found by
+    *   and what is swapped for nullptr to leave a tombstone. by default the entry is just
+    *   the pointer, specialise to store more next to it.
+    */
+    template<typename Entry>
+    struct entry_traits {
+        static_assert(std::is_pointer_v<Entry>);
+
+        using pointer = Entry;
+
+        static Entry make(pointer p) { return p; }
+        static pointer& key(Entry& e) { return e; }
+        static pointer key(const Entry& e) { return e; }
+    };
+}
+
+#endif // RPT_DETAIL_ENTRY_TRAITS
@@ -0,0 +1,634 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#ifndef RPT_DETAIL_EPOCH_DOMAIN
+#define RPT_DETAIL_EPOCH_DOMAIN
+
+#include "tracepoints.hpp"
+#include "waitable_atomic.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace rpt::event_detail {
+
+    /*
+    *   epoch based reclamation shared by every event.
+    *
+    *   readers announce the global epoch in a record for the length of a read side critical
+    *   section, there is no shared reference count to touch. writers unpublish an object and
+    *   retire it tagged with the current epoch, retired objects are freed in batches once
+    *   every record is either idle or has announced a later epoch.
+    *
+    *   a read section may name a scope, the event it dispatches. synchronize waits for the
+    *   sections of one scope only, so unsubscribing from one event never waits on another
+    *   event's dispatches. freeing memory still waits for every section.
+    *
+    *   synchronize may be called from inside a read section, the caller's own sections are
+    *   not waited for. while it waits the caller is parked, another synchronizer may then
+    *   look through the lists the parked thread is dispatching instead of waiting on it.
+    */
+    class epoch_domain {
+        static constexpr std::uint64_t idle = 0;
+
+    public:
+        static constexpr std::size_t cache_line_size = 64;
+        static constexpr std::size_t retire_batch_size = 64;
+        static constexpr std::size_t scope_depth = 8;
+
+        /*
+            a scoped read section of a thread, what it is dispatching and who it is calling.
+            only the owning thread writes it, others read it while the owner is parked.
+        */
+        struct frame {
+            const void* scope;
+            void* first{ nullptr };
+            std::size_t size{ 0 };
+            const void* current{ nullptr };
+            frame* outer{ nullptr };
+        };
+
+        struct alignas(cache_line_size) record {
+            std::atomic<std::uint64_t> epoch{ idle };
+            std::atomic<bool> in_use{ true };
+            std::size_t nesting{ 0 };
+            record* next{ nullptr };
+
+            // scope of each open section, innermost last. sections nested deeper than
+            // scope_depth are counted in overflow and the record then reads every scope.
+            std::array<std::atomic<const void*>, scope_depth> scopes{};
+            std::atomic<std::uint32_t> overflow{ 0 };
+
+            // innermost scoped section, only followed by visitors while parked is set.
+            frame* frames{ nullptr };
+            std::atomic<bool> parked{ false };
+            std::atomic<std::uint32_t> visitors{ 0 };
+        };
+
+        /*
+            read side critical section on the calling thread's record, may be nested.
+        */
+        class read_guard {
+        public:
+            read_guard(epoch_domain&, const void* scope, std::uint64_t joined = idle);
+            read_guard(const read_guard&) = delete;
+            read_guard& operator=(const read_guard&) = delete;
+            ~read_guard();
+
+            /*
+                the entries the section goes through, synchronizers may tombstone them while
+                the thread is parked.
+            */
+            void track(void* first, std::size_t size);
+
+            /*
+                the listener about to be called.
+            */
+            void calling(const void* listener);
+
+        private:
+            friend epoch_domain;
+
+            epoch_domain& domain;
+            record& rec;
+            frame f;
+        };
+
+        epoch_domain(const epoch_domain&) = delete;
+        epoch_domain& operator=(const epoch_domain&) = delete;
+
+        /*
+            the domain used by all events, never destroyed so threads may exit in any order.
+        */
+        static epoch_domain& instance();
+
+        /*
+            scope is what synchronize waits on, sections without one only hold back freeing.
+        */
+        read_guard read_lock(const void* scope = nullptr);
+
+        /*
+            section for work handed to another thread by the owner of joined, it counts as
+            having started with joined so it sees nothing that joined could not.
+        */
+        read_guard read_lock(const void* scope, const read_guard& joined);
+
+        /*
+            read side critical section on a record of its own, it is not tied to the calling
+            thread and may be released from any thread.
+        */
+        record* pin(const void* scope = nullptr);
+        void unpin(record*);
+
+        /*
+            link embedded in whatever is retired, so retiring never allocates.
+        */
+        struct retired {
+            retired* next{ nullptr };
+            void(*deleter)(retired&){ nullptr };
+            std::uint64_t epoch{ 0 };
+        };
+
+        /*
+            hand an object that readers can no longer reach to the domain, deleter is called
+            on it once it is safe.
+        */
+        void retire(retired&);
+
+        /*
+            retire an object without a link of its own, one is allocated for it.
+        */
+        template<typename T>
+        void retire(T* ptr);
+        void retire(void* ptr, void(*deleter)(void*));
+
+        /*
+            block until every read side critical section of scope that was active when called
+            has ended, every section when scope is nullptr, then free what is already safe.
+            the calling thread's own sections are not waited for.
+        */
+        void synchronize(const void* scope = nullptr);
+
+        /*
+            synchronize, forget(frame&, bool own) is run on the frames of scope of the calling
+            thread and of parked threads. returning true for every frame of a parked thread
+            says it can no longer reach what is going away and it is not waited for.
+        */
+        template<typename Forget>
+        void synchronize(const void* scope, Forget&& forget);
+
+        /*
+            free whatever retired objects are already safe, never blocks.
+        */
+        void reclaim();
+
+        /*
+            a synchronize left to the reclaimer thread. parked threads are only waited for
+            while they are calling listener, done is called once the grace period is over.
+        */
+        struct deferred {
+            deferred* next{ nullptr };
+            const void* scope{ nullptr };
+            const void* listener{ nullptr };
+            void(*done)(deferred&){ nullptr };
+        };
+
+        /*
+            have the reclaimer thread run synchronize on the caller's behalf, the request
+            must stay alive until done is called. the thread is started on first use.
+        */
+        void synchronize_async(deferred&);
+
+        /*
+            true if the calling thread is inside a read side critical section.
+        */
+        bool in_read_section();
+
+        /*
+            while parked a thread blocked inside a read section, on something other than a
+            callback, may be visited by synchronizers instead of waited for. see synchronize.
+        */
+        void park();
+        void unpark();
+
+    private:
+
+        /*
+            thread records are cached per thread, so there is only the one domain.
+        */
+        epoch_domain() = default;
+
+        struct thread_record {
+            record* rec{ nullptr };
+            ~thread_record();
+        };
+
+        record& local_record();
+        record* acquire_record();
+        void release_record(record*);
+
+        void enter(record&, const void* scope, std::uint64_t joined);
+        void exit(record&);
+
+        /*
+            oldest epoch announced by an active record, or the current epoch if none are active.
+        */
+        std::uint64_t oldest_active(std::uint64_t current) const;
+
+        static bool reads(const record&, const void* scope);
+
+        /*
+            number of records visit remembers as safe during one synchronize.
+        */
+        static constexpr std::size_t visit_cache_size = 8;
+
+        /*
+            true while a record other than own is holding up a synchronize of scope. records
+            found safe by visit are added to visited.
+        */
+        template<typename Forget>
+        bool blocking_readers(const record& own, std::uint64_t target, const void* scope, Forget& forget,
+            std::array<const record*, visit_cache_size>& visited, std::size_t& visited_count);
+
+        /*
+            run forget on the frames of a parked record, true if all of them said it is safe.
+        */
+        template<typename Forget>
+        static bool visit(record&, const void* scope, Forget& forget);
+
+        void park(record&);
+        void unpark(record&);
+
+        void free_before(std::uint64_t epoch);
+
+        void run_reclaimer();
+
+        alignas(cache_line_size) std::atomic<std::uint64_t> global_epoch{ 1 };
+        std::atomic<record*> records{ nullptr };
+
+        /*
+            number of threads blocked in synchronize. readers only bump call_complete on the way
+            out of a critical section while it is non zero, so an uncontended dispatch never
+            writes to a shared cache line.
+        */
+        alignas(cache_line_size) std::atomic<std::uint32_t> synchronizers{ 0 };
+
+        alignas(cache_line_size) waitable_atomic<std::uint64_t> call_complete{ 0 };
+
+        std::mutex retired_mutex;
+        retired* retired_list{ nullptr };
+        std::size_t retired_count{ 0 };
+
+        /*
+            retire reclaims once the list reaches this size, it is kept at twice what the last
+            pass left behind so objects that are not safe yet are not rescanned on every retire.
+        */
+        std::size_t reclaim_threshold{ retire_batch_size };
+
+        // requests pushed by synchronize_async, reclaim_requests is bumped after each push.
+        std::once_flag reclaimer_started;
+        std::atomic<deferred*> deferred_requests{ nullptr };
+        waitable_atomic<std::uint64_t> reclaim_requests{ 0 };
+    };
+
+    inline epoch_domain::read_guard::read_guard(epoch_domain& domain, const void* scope, std::uint64_t joined)
+        : domain{ domain }
+        , rec{ domain.local_record() }
+        , f{ scope }
+    {
+        if (scope != nullptr) {
+            f.outer = rec.frames;
+            rec.frames = &f;
+        }
+        domain.enter(rec, scope, joined);
+    }
+
+    inline epoch_domain::read_guard::~read_guard() {
+        domain.exit(rec);
+        if (f.scope != nullptr)
+            rec.frames = f.outer;
+    }
+
+    inline void epoch_domain::read_guard::track(void* first, std::size_t size) {
+        f.first = first;
+        f.size = size;
+    }
+
+    inline void epoch_domain::read_guard::calling(const void* listener) {
+        f.current = listener;
+    }
+
+    inline epoch_domain::thread_record::~thread_record() {
+        if (rec != nullptr)
+            instance().release_record(rec);
+    }
+
+    inline epoch_domain& epoch_domain::instance() {
+        static auto* domain = new epoch_domain{};
+        return *domain;
+    }
+
+    inline epoch_domain::read_guard epoch_domain::read_lock(const void* scope) {
+        return read_guard{ *this, scope };
+    }
+
+    inline epoch_domain::read_guard epoch_domain::read_lock(const void* scope, const read_guard& joined) {
+        return read_guard{ *this, scope, joined.rec.epoch.load(std::memory_order_relaxed) };
+    }
+
+    inline epoch_domain::record* epoch_domain::pin(const void* scope) {
+        auto rec = acquire_record();
+        enter(*rec, scope, idle);
+        return rec;
+    }
+
+    inline void epoch_domain::unpin(record* rec) {
+        exit(*rec);
+        release_record(rec);
+    }
+
+    template<typename T>
+    void epoch_domain::retire(T* ptr) {
+        retire(ptr, [](void* p) { delete static_cast<T*>(p); });
+    }
+
+    inline void epoch_domain::retire(retired& r) {
+        auto batch_full = false;
+        {
+            auto lock = std::lock_guard{ retired_mutex };
+            r.epoch = global_epoch.load();
+            r.next = retired_list;
+            retired_list = &r;
+            batch_full = ++retired_count >= reclaim_threshold;
+        }
+
+        if (batch_full)
+            reclaim();
+    }
+
+    inline void epoch_domain::retire(void* ptr, void(*deleter)(void*)) {
+        struct retired_object : retired {
+            void* ptr;
+            void(*object_deleter)(void*);
+        };
+
+        auto* r = new retired_object{};
+        r->ptr = ptr;
+        r->object_deleter = deleter;
+        r->deleter = [](retired& base) {
+            auto* self = static_cast<retired_object*>(&base);
+            self->object_deleter(self->ptr);
+            delete self;
+        };
+        retire(*r);
+    }
+
+    inline void epoch_domain::synchronize(const void* scope) {
+        synchronize(scope, [](frame&, bool) { return false; });
+    }
+
+    template<typename Forget>
+    void epoch_domain::synchronize(const void* scope, Forget&& forget) {
+        auto& own = local_record();
+
+        // the caller's own sections only end once it returns, they are told what is going away.
+        for (auto f = own.frames; f != nullptr; f = f->outer) {
+            if (f->scope == scope)
+                forget(*f, true);
+        }
+
+        auto target = global_epoch.fetch_add(1) + 1;
+
+        auto nested = own.nesting != 0;
+        if (nested)
+            park(own);
+
+        auto visited = std::array<const record*, visit_cache_size>{};
+        auto visited_count = std::size_t{ 0 };
+        if (blocking_readers(own, target, scope, forget, visited, visited_count)) {
+            synchronizers++;
+            auto current_complete = call_complete.load();
+            while (blocking_readers(own, target, scope, forget, visited, visited_count)) {
+                call_complete.wait(current_complete);
+                current_complete = call_complete.load();
+            }
+            synchronizers--;
+        }
+
+        if (nested)
+            unpark(own);
+
+        // sections of other scopes may still hold back some of what was retired.
+        free_before(oldest_active(target));
+    }
+
+    inline void epoch_domain::reclaim() {
+        auto current = global_epoch.fetch_add(1) + 1;
+        free_before(oldest_active(current));
+    }
+
+    inline void epoch_domain::synchronize_async(deferred& request) {
+        std::call_once(reclaimer_started, [this]() {
+            // the domain is never destroyed, the thread is left running at exit.
+            std::thread([this]() { run_reclaimer(); }).detach();
+        });
+
+        request.next = deferred_requests.load(std::memory_order_relaxed);
+        while (!deferred_requests.compare_exchange_weak(request.next, &request, std::memory_order_release, std::memory_order_relaxed)) {}
+
+        reclaim_requests++;
+        reclaim_requests.notify_all();
+    }
+
+    inline bool epoch_domain::in_read_section() {
+        return local_record().nesting != 0;
+    }
+
+    inline void epoch_domain::park() {
+        park(local_record());
+    }
+
+    inline void epoch_domain::unpark() {
+        unpark(local_record());
+    }
+
+    inline epoch_domain::record& epoch_domain::local_record() {
+        thread_local auto local = thread_record{};
+        if (local.rec == nullptr)
+            local.rec = acquire_record();
+        return *local.rec;
+    }
+
+    inline epoch_domain::record* epoch_domain::acquire_record() {
+        for (auto rec = records.load(); rec != nullptr; rec = rec->next) {
+            auto expected = false;
+            if (!rec->in_use.load(std::memory_order_relaxed) && rec->in_use.compare_exchange_strong(expected, true))
+                return rec;
+        }
+
+        auto rec = new record{};
+        rec->next = records.load();
+        while (!records.compare_exchange_weak(rec->next, rec)) {}
+        return rec;
+    }
+
+    inline void epoch_domain::release_record(record* rec) {
+        assert(rec->nesting == 0);
+        rec->in_use.store(false, std::memory_order_release);
+    }
+
+    inline void epoch_domain::enter(record& rec, const void* scope, std::uint64_t joined) {
+        if (rec.nesting < scope_depth)
+            rec.scopes[rec.nesting].store(scope, std::memory_order_relaxed);
+        else
+            rec.overflow.fetch_add(1, std::memory_order_relaxed);
+
+        // the scope is stored first, a synchronizer that sees the epoch sees the scope too.
+        // a joined epoch is only ever lowered to, until the outermost section ends.
+        if (rec.nesting++ == 0)
+            rec.epoch.store(joined != idle ? joined : global_epoch.load(), std::memory_order_release);
+        else if (joined != idle && joined < rec.epoch.load(std::memory_order_relaxed))
+            rec.epoch.store(joined, std::memory_order_release);
+        else if (scope == nullptr)
+            return;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    inline void epoch_domain::exit(record& rec) {
+        assert(rec.nesting != 0);
+        auto depth = --rec.nesting;
+        auto scoped = depth >= scope_depth || rec.scopes[depth].load(std::memory_order_relaxed) != nullptr;
+
+        // seq_cst store then load, either the synchronizer sees the section over or we see it waiting.
+        if (depth >= scope_depth)
+            rec.overflow.fetch_sub(1);
+        else if (scoped)
+            rec.scopes[depth].store(nullptr, depth == 0 ? std::memory_order_release : std::memory_order_seq_cst);
+
+        if (depth == 0)
+            rec.epoch.store(idle);
+        else if (!scoped)
+            return;
+
+        if (synchronizers.load() != 0) {
+            call_complete++;
+            call_complete.notify_all();
+        }
+    }
+
+    inline std::uint64_t epoch_domain::oldest_active(std::uint64_t current) const {
+        auto oldest = current;
+        for (auto rec = records.load(); rec != nullptr; rec = rec->next) {
+            auto epoch = rec->epoch.load();
+            if (epoch != idle && epoch < oldest)
+                oldest = epoch;
+        }
+        return oldest;
+    }
+
+    template<typename Forget>
+    bool epoch_domain::blocking_readers(const record& own, std::uint64_t target, const void* scope, Forget& forget,
+        std::array<const record*, visit_cache_size>& visited, std::size_t& visited_count)
+    {
+        for (auto rec = records.load(); rec != nullptr; rec = rec->next) {
+            if (rec == &own)
+                continue;
+
+            auto epoch = rec->epoch.load();
+            if (epoch == idle || epoch >= target || !reads(*rec, scope))
+                continue;
+
+            // sections a visited record enters later only see lists that are already updated.
+            if (std::find(visited.begin(), std::next(visited.begin(), visited_count), rec) != std::next(visited.begin(), visited_count))
+                continue;
+
+            if (scope == nullptr || !visit(*rec, scope, forget))
+                return true;
+
+            if (visited_count < visit_cache_size)
+                visited[visited_count++] = rec;
+        }
+        return false;
+    }
+
+    template<typename Forget>
+    bool epoch_domain::visit(record& rec, const void* scope, Forget& forget) {
+        if (!rec.parked.load())
+            return false;
+
+        // seq_cst increment then load, either the owner sees the visitor or we see it leave.
+        rec.visitors++;
+        auto safe = rec.parked.load();
+        for (auto f = safe ? rec.frames : nullptr; f != nullptr; f = f->outer) {
+            if (f->scope == scope && !forget(*f, false)) {
+                safe = false;
+                break;
+            }
+        }
+        rec.visitors--;
+        return safe;
+    }
+
+    inline void epoch_domain::park(record& rec) {
+        rec.parked.store(true);
+        if (synchronizers.load() != 0) {
+            call_complete++;
+            call_complete.notify_all();
+        }
+    }
+
+    inline void epoch_domain::unpark(record& rec) {
+        // the frames belong to the visitors until they have all left.
+        rec.parked.store(false);
+        while (rec.visitors.load() != 0)
+            std::this_thread::yield();
+    }
+
+    inline bool epoch_domain::reads(const record& rec, const void* scope) {
+        if (scope == nullptr || rec.overflow.load() != 0)
+            return true;
+        return std::any_of(rec.scopes.begin(), rec.scopes.end(), [scope](auto& s) {
+            return s.load() == scope;
+        });
+    }
+
+    inline void epoch_domain::free_before(std::uint64_t epoch) {
+        auto batch = static_cast<retired*>(nullptr);
+        auto batch_size = std::size_t{ 0 };
+        {
+            auto lock = std::lock_guard{ retired_mutex };
+            for (auto link = &retired_list; *link != nullptr;) {
+                auto r = *link;
+                if (r->epoch < epoch) {
+                    *link = r->next;
+                    r->next = batch;
+                    batch = r;
+                    batch_size++;
+                }
+                else {
+                    link = &r->next;
+                }
+            }
+            retired_count -= batch_size;
+            reclaim_threshold = std::max(retire_batch_size, retired_count * 2);
+        }
+
+        RPT_TRACE2(reclaim, epoch, batch_size);
+        while (batch != nullptr) {
+            // the deleter frees the link, next is read first.
+            auto next = batch->next;
+            batch->deleter(*batch);
+            batch = next;
+        }
+    }
+
+    inline void epoch_domain::run_reclaimer() {
+        while (true) {
+            auto requested = reclaim_requests.load();
+            auto request = deferred_requests.exchange(nullptr, std::memory_order_acquire);
+            if (request == nullptr) {
+                reclaim_requests.wait(requested);
+                continue;
+            }
+
+            while (request != nullptr) {
+                // done may release the request, next is read first.
+                auto next = request->next;
+                synchronize(request->scope, [request](frame& f, bool) {
+                    return f.current != request->listener;
+                });
+                request->done(*request);
+                request = next;
+            }
+        }
+    }
+}
+
+#endif // RPT_DETAIL_EPOCH_DOMAIN
@@ -8,8 +8,19 @@
 #include "array_generator.hpp"
 #include "array_viewer.hpp"
 #include "listener_base.hpp"
+#include "metrics_recorder.hpp"
+#include "param_traits.hpp"
+#include "tracepoints.hpp"
 #include "waitable_atomic.hpp"
-#include "atomic_shared_array.hpp"
+#include "epoch_domain.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <type_traits>
+#include <utility>
 
 
 namespace rpt::event_detail {
@@ -26,22 +37,68 @@ namespace rpt::event_detail {
             : generator(alloc)
         {}
 
-        using array_type = std::shared_ptr<listener_base<Params...>* []>;
+        event_base(const event_base&) = delete;
+        event_base& operator=(const event_base&) = delete;
+
+        ~event_base();
+
+        allocator_type get_allocator() const;
+
+        using entry_type = dispatch_entry<Params...>;
+        using array_type = std::shared_ptr<entry_type[]>;
+        using view_type = array_viewer<listener_base<Params...>, entry_type>;
 
         /*
             Method to call from listener base in order to remove the litener from the array.
+            the listener's slot is replaced with a tombstone in place, the array is only
+            copied once enough tombstones have built up.
+            returns once no dispatch can still be calling the listener, see wait_for_unlinked.
         */
         void repudiate(listener_base<Params...>&);
 
-        template<typename... Args>
-        void operator()(Args&&...);
+        /*
+            block until no dispatch can still call a listener that was unlinked. dispatches
+            on the calling thread are not waited for, neither are those of threads that are
+            waiting themselves unless they are inside the listener. the listener is
+            tombstoned in the lists they are going through instead.
+        */
+        void wait_for_unlinked(listener_base<Params...>&);
+
+        /*
+            repudiate without waiting, dispatches that are already running may still call the
+            listener so it has to be kept alive until the epoch domain says otherwise.
+            safe to call from inside a dispatch.
+        */
+        void unlink(listener_base<Params...>&);
+
+        /*
+            call every listener, the arguments are converted to their param_t once
+            and the same objects are handed to each listener.
+        */
+        void operator()(param_t<Params>...);
+
+        /*
+            call every listener, splitting the list into chunks of grain_size that run on
+            pool alongside the calling thread. lists shorter than sequential_threshold are
+            called in place. returns once every chunk has finished.
+        */
+        template<typename Executor>
+        void fan_out(Executor& pool, std::size_t grain_size, std::size_t sequential_threshold, param_t<Params>...);
 
         /*
             Add a listener to the list of subscribers
             from the start of this function call the lisener may be invoked.
+            does not wait for dispatches that are already running.
         */
         void subscribe(listener_base<Params...>&);
 
+        /*
+            Subscribe and repudiate many listeners with a single new array.
+            removed must be sorted, waits once for running dispatches if anything was removed.
+        */
+        template<typename AddRange, typename RemoveRange>
+        void update(const AddRange& added, const RemoveRange& removed);
+
         /*
             Clear the list and wait for it to be safe to destruct event_base
         */
@@ -52,42 +109,105 @@ namespace rpt::event_detail {
         */
         bool empty() const;
 
-        array_viewer<listener_base<Params...>> view_lock();
+        view_type view_lock();
+
+        /*
+            the event's counters, empty unless RPT_ENABLE_METRICS is set.
+        */
+        event_metrics metrics() const;
 
     private:
-        using generator_type = array_generator<listener_base<Params...>*>;
+        using generator_type = array_generator<entry_type>;
         using listener_type = listener_base<Params...>;
         
         /*
-            for 20 ArrModFn should be a concept
+            compact once more than 1 / compact_ratio of the slots are tombstones.
+        */
+        static constexpr std::size_t compact_ratio = 4;
+
+        /*
+            the listener list is held in data as one word, nothing (0), a single listener
+            tagged with single_tag or a pointer to a heap array. events with no or one
+            listener never allocate and dispatch straight from the word.
+        */
+        static constexpr std::uintptr_t single_tag = 1;
+        static_assert(alignof(listener_base<Params...>) > single_tag);
+
+        /*
+            what the word points to for a heap array, allocated from the event's resource
+            and retired through its own link.
+        */
+        struct array_holder : epoch_domain::retired {
+            array_holder(array_type&& array, std::pmr::memory_resource* resource, recorder_type::array_token token);
+
+            static void destroy(epoch_domain::retired&);
+
+            array_type array;
+            std::pmr::memory_resource* resource;
+
+            // counts the free, the event may be gone by the time the domain reclaims it.
+            [[no_unique_address]] recorder_type::array_token token;
+        };
+
+        static bool is_array(std::uintptr_t word);
+        static listener_type* as_single(std::uintptr_t word);
+        static array_type& as_array(std::uintptr_t word);
+
+        /*
+            first and size of the entries in word. a single listener is copied into single,
+            the range is valid for the rest of the caller's read side critical section.
+        */
+        static std::pair<entry_type*, std::size_t> entries(std::uintptr_t word, entry_type& single);
+
+        /*
+            the current list as a heap array, write_mutex must be held.
         */
-        template<typename ArrModFn>
-        void replace_data_using(ArrModFn&& fn);
+        array_type current_array(std::uintptr_t word) const;
 
         /*
-            get a copy of hte list that cannot be detructed while the shared pointer (array_type) is held.
+            publish next, arrays of no or one listener are stored in the word instead.
+            write_mutex must be held.
         */
-        array_type lock();
+        void publish(array_type&& next);
 
         /*
-            block untill the generation atomic changes value. Then return the new value.
+            publish the list word and retire the array it replaced to the epoch domain.
+            write_mutex must be held.
         */
-        void wait_on_generatrion_equal(uint64_t value);
+        void replace_list(std::uintptr_t next);
 
         /*
-            block until the number of viewers is equal to the requested value
+            store the index of every listener in the current array, write_mutex must be held.
+        */
+        void update_slots();
 
-            only call when viewers can only decreas
+        /*
+            block until no more than remaining listeners are left in the list.
+        */
+        void wait_on_listener_count(std::size_t remaining);
+
+        /*
+            domain.synchronize scoped to this event, timed when metrics are on.
+            dispatches and views of other events are not waited for.
         */
-        void wait_on_viewer_count(const array_type& arr, long count);
+        void wait_for_readers();
+        template<typename Forget>
+        void wait_for_readers(Forget&& forget);
 
-        using atomic_array_type = atomic_shared_array_t<listener_base<Params...>*>;
+        std::unique_lock<std::mutex> lock_writers();
+
+        epoch_domain& domain{ epoch_domain::instance() };
 
         generator_type generator;
-        
-        atomic_uintptr_t call_complete{ 0 };
-        atomic_uintptr_t free_generation{ 0 };
-        atomic_array_type data{ generator.make_array() };
+
+        // writers are serialised so a tombstone is never lost to a copy made at the same time.
+        std::mutex write_mutex;
+        std::size_t tombstones{ 0 };
+
+        atomic_uintptr_t write_count{ 0 };
+        std::atomic<std::uintptr_t> data{ 0 };
+
+        [[no_unique_address]] recorder_type recorder;
     };
 }
 
@@ -112,110 +232,452 @@ namespace rpt::event_detail{
     };
 
     template<typename... Params>
-    array_viewer<listener_base<Params...>> event_base<Params...>::view_lock()
+    event_base<Params...>::~event_base() {
+        if (auto word = data.load(); is_array(word))
+            array_holder::destroy(*reinterpret_cast<array_holder*>(word));
+    }
+
+    template<typename... Params>
+    typename event_base<Params...>::allocator_type event_base<Params...>::get_allocator() const {
+        return allocator_type{ generator.get_allocator().resource() };
+    }
+
+    template<typename... Params>
+    event_base<Params...>::array_holder::array_holder(array_type&& array, std::pmr::memory_resource* resource, recorder_type::array_token token)
+        : array{ std::move(array) }
+        , resource{ resource }
+        , token{ std::move(token) }
     {
-        auto holder = lock();
-        auto size = generator.get_size(holder);
-        auto ptr = generator.get_data(holder);
-        return array_viewer<listener_base<Params...>> {
-            std::shared_ptr<listener_base<Params...>*[]>{std::move(holder), ptr},
-            size
+        deleter = &destroy;
+    }
+
+    template<typename... Params>
+    void event_base<Params...>::array_holder::destroy(epoch_domain::retired& r) {
+        auto& holder = static_cast<array_holder&>(r);
+        recorder_type::array_freed(holder.token);
+        std::pmr::polymorphic_allocator<array_holder>{ holder.resource }.delete_object(&holder);
+    }
+
+    template<typename... Params>
+    typename event_base<Params...>::view_type event_base<Params...>::view_lock()
+    {
+        auto pin = domain.pin(this);
+        auto word = data.load(std::memory_order_acquire);
+        if (is_array(word)) {
+            auto& holder = as_array(word);
+            return view_type {
+                std::shared_ptr<entry_type[]>{generator.get_data(holder), [&domain = domain, pin](auto*) {
+                    domain.unpin(pin);
+                }, generator.get_allocator()},
+                generator.get_size(holder)
+            };
+        }
+
+        // there is no array to point into, the view keeps its own copy of the entry.
+        struct pinned_entry {
+            ~pinned_entry() { domain.unpin(pin); }
+
+            epoch_domain& domain;
+            epoch_domain::record* pin;
+            entry_type entry;
+        };
+
+        auto holder = std::allocate_shared<pinned_entry>(generator.get_allocator(), domain, pin, word ? generator_type::traits_type::make(as_single(word)) : entry_type{});
+        return view_type {
+            std::shared_ptr<entry_type[]>{ holder, &holder->entry },
+            word ? std::size_t{ 1 } : std::size_t{ 0 }
         };
     }
 
     template<typename... Params>
-    template<typename... Args>
-    void event_base<Params...>::operator()(Args&&... args) {
-        auto view = event_detail::array_viewer{ view_lock() };
-        std::for_each(view.begin(), view.end(), [args...](auto& l) {
-            l(args...);
-       });
-       call_complete++;
-       call_complete.notify_all();
+    void event_base<Params...>::operator()(param_t<Params>... params) {
+        auto start = recorder.now();
+        auto guard = domain.read_lock(this);
+        auto word = data.load(std::memory_order_acquire);
+        if (!is_array(word)) {
+            RPT_TRACE2(dispatch_begin, trace_address(this), word != 0);
+            if (word) {
+                guard.calling(as_single(word));
+                (*as_single(word))(params...);
+            }
+            RPT_TRACE2(dispatch_end, trace_address(this), word != 0);
+        }
+        else {
+            auto& holder = as_array(word);
+            auto size = generator.get_size(holder);
+            RPT_TRACE2(dispatch_begin, trace_address(this), size);
+            guard.track(generator.get_data(holder), size);
+            std::for_each_n(generator.get_data(holder), size, [&](auto& entry) {
+                if (auto l = generator_type::load_entry(entry)) {
+                    guard.calling(l);
+                    entry.callback(*l, params...);
+                }
+            });
+            RPT_TRACE2(dispatch_end, trace_address(this), size);
+        }
+        recorder.dispatched(start);
+    }
+
+    template<typename... Params>
+    template<typename Executor>
+    void event_base<Params...>::fan_out(Executor& pool, std::size_t grain_size, std::size_t sequential_threshold, param_t<Params>... params) {
+        // chunks run on other threads in read sections that join this thread's, it is not
+        // left until they have all finished.
+        auto start = recorder.now();
+        auto guard = domain.read_lock(this);
+        auto single = entry_type{};
+        auto range = entries(data.load(std::memory_order_acquire), single);
+        auto first = range.first;
+        auto size = range.second;
+        RPT_TRACE2(dispatch_begin, trace_address(this), size);
+        guard.track(first, size);
+
+        grain_size = std::max<std::size_t>(grain_size, 1);
+        if (size < sequential_threshold || size <= grain_size) {
+            std::for_each_n(first, size, [&](auto& entry) {
+                if (auto l = generator_type::load_entry(entry)) {
+                    guard.calling(l);
+                    entry.callback(*l, params...);
+                }
+            });
+            RPT_TRACE2(dispatch_end, trace_address(this), size);
+            recorder.dispatched(start);
+            return;
+        }
+
+        struct fan_out_state {
+            std::size_t chunks;
+            std::atomic<std::size_t> next_chunk{ 0 };
+            waitable_atomic<std::uint64_t> finished_chunks{ 0 };
+        };
+
+        // helpers that only start once every chunk is taken touch nothing but the state.
+        auto state = std::make_shared<fan_out_state>((size + grain_size - 1) / grain_size);
+        auto chunks = state->chunks;
+
+        // runs from a taken chunk on, this thread waits for that chunk so the references hold.
+        auto run_chunks = [&](std::size_t chunk) {
+            auto chunk_guard = domain.read_lock(this, guard);
+            chunk_guard.track(first, size);
+            for (; chunk < chunks; chunk = state->next_chunk++) {
+                auto chunk_first = std::next(first, chunk * grain_size);
+                std::for_each_n(chunk_first, std::min(grain_size, size - chunk * grain_size), [&](auto& entry) {
+                    if (auto l = generator_type::load_entry(entry)) {
+                        chunk_guard.calling(l);
+                        entry.callback(*l, params...);
+                    }
+                });
+
+                state->finished_chunks++;
+                state->finished_chunks.notify_all();
+            }
+        };
+
+        // small enough to be stored in the executor's ring without allocating.
+        auto helper = [state, &run_chunks]() {
+            if (auto chunk = state->next_chunk++; chunk < state->chunks)
+                run_chunks(chunk);
+        };
+
+        auto helpers = std::min<std::size_t>(chunks - 1, pool.size());
+        for (auto i = std::size_t{ 0 }; i < helpers; i++)
+            pool.submit(helper);
+
+        helper();
+
+        // a helper unsubscribing from a callback can look through this thread's list
+        // instead of waiting on it.
+        domain.park();
+        for (auto finished = state->finished_chunks.load(); finished != chunks; finished = state->finished_chunks.load())
+            state->finished_chunks.wait(finished);
+        domain.unpark();
+
+        RPT_TRACE2(dispatch_end, trace_address(this), size);
+        recorder.dispatched(start);
     }
 
     template<typename... Params>
     bool event_base<Params...>::empty() const {
-        return (generator.get_size(data.load()) == 0);
-        //return data.load() == nullptr;
+        auto guard = domain.read_lock();
+        auto single = entry_type{};
+        auto [first, size] = entries(data.load(std::memory_order_acquire), single);
+        return std::none_of(first, std::next(first, size), [](auto& entry) {
+            return generator_type::load_entry(entry) != nullptr;
+        });
     }
 
     template<typename... Params>
-    typename event_base<Params...>::array_type event_base<Params...>::lock() {
-        return data.load();
+    bool event_base<Params...>::is_array(std::uintptr_t word) {
+        return word != 0 && (word & single_tag) == 0;
     }
 
     template<typename... Params>
-    void event_base<Params...>::wait_on_generatrion_equal(uint64_t value) {
-        auto current_generation = free_generation.load();
-        while (current_generation != value) {
-            free_generation.wait(current_generation);
-            current_generation = free_generation.load();
-        }
+    typename event_base<Params...>::listener_type* event_base<Params...>::as_single(std::uintptr_t word) {
+        return reinterpret_cast<listener_type*>(word & ~single_tag);
     }
 
     template<typename... Params>
-    void event_base<Params...>::wait_on_viewer_count(const array_type& arr, long target_count) {
-        auto current_complete = call_complete.load();
-        auto current_count = arr.use_count();
-        while (current_count > target_count) {
-            call_complete.wait(current_complete);
-            current_complete = call_complete.load();
-            current_count = arr.use_count();
-        }
+    typename event_base<Params...>::array_type& event_base<Params...>::as_array(std::uintptr_t word) {
+        return reinterpret_cast<array_holder*>(word)->array;
     }
 
     template<typename... Params>
-    template<typename ArrModFn>
-    void event_base<Params...>::replace_data_using(ArrModFn&& fn) {
-        auto holder = lock();
-        auto next = fn(holder);
-        while (!data.compare_exchange_strong(holder, next))
-        {
-            next = fn(holder);
+    std::pair<typename event_base<Params...>::entry_type*, std::size_t> event_base<Params...>::entries(std::uintptr_t word, entry_type& single) {
+        if (is_array(word))
+            return { generator_type::get_data(as_array(word)), generator_type::get_size(as_array(word)) };
+
+        single = word ? generator_type::traits_type::make(as_single(word)) : entry_type{};
+        return { &single, word ? 1 : 0 };
+    }
+
+    template<typename... Params>
+    typename event_base<Params...>::array_type event_base<Params...>::current_array(std::uintptr_t word) const {
+        if (is_array(word))
+            return as_array(word);
+        return word ? generator.make_array(*as_single(word)) : generator.make_array();
+    }
+
+    template<typename... Params>
+    void event_base<Params...>::wait_on_listener_count(std::size_t remaining) {
+        auto current_count = write_count.load();
+        while (true) {
+            {
+                auto guard = domain.read_lock();
+                auto single = entry_type{};
+                auto [first, size] = entries(data.load(std::memory_order_acquire), single);
+                auto live = std::count_if(first, std::next(first, size), [](auto& entry) {
+                    return generator_type::load_entry(entry) != nullptr;
+                });
+                if (static_cast<std::size_t>(live) <= remaining)
+                    return;
+            }
+            write_count.wait(current_count);
+            current_count = write_count.load();
         }
+    }
 
-        wait_on_viewer_count(holder, 1);
+    template<typename... Params>
+    void event_base<Params...>::publish(array_type&& next) {
+        switch (generator.get_size(next)) {
+        case 0:
+            replace_list(0);
+            break;
+        case 1:
+            replace_list(reinterpret_cast<std::uintptr_t>(generator.get_data(next)[0].listener) | single_tag);
+            break;
+        default: {
+            auto* resource = generator.get_allocator().resource();
+            auto* holder = std::pmr::polymorphic_allocator<array_holder>{ resource }.template new_object<array_holder>(std::move(next), resource, recorder.array_allocated());
+            replace_list(reinterpret_cast<std::uintptr_t>(holder));
+            break;
+        }
+        }
+    }
 
-        auto generatrion = generator.get_generation(holder);
-        holder = nullptr;
+    template<typename... Params>
+    void event_base<Params...>::replace_list(std::uintptr_t next) {
+        if (auto previous = data.exchange(next, std::memory_order_acq_rel); is_array(previous)) {
+            domain.retire(*reinterpret_cast<array_holder*>(previous));
+            recorder.array_retired();
+        }
+        recorder.written();
 
-        wait_on_generatrion_equal(generatrion);
+        [[maybe_unused]] auto generation = write_count++ + 1;
+        RPT_TRACE3(list_publish, trace_address(this), generation,
+            is_array(next) ? generator.get_size(as_array(next)) : std::size_t{ next != 0 });
+        write_count.notify_all();
+    }
 
-        free_generation++;
+    template<typename... Params>
+    void event_base<Params...>::update_slots() {
+        auto single = entry_type{};
+        auto [first, size] = entries(data.load(std::memory_order_relaxed), single);
+        for (auto i = std::size_t{ 0 }; i < size; i++)
+            first[i].listener->_slot = i;
     }
 
     template<typename... Params>
     void event_base<Params...>::subscribe(listener_base<Params...>& l) {
-        replace_data_using([&](const auto& arr) {
-            return generator.copy_push_back(arr, l);
-        });
+        auto lock_guard = lock_writers();
+        auto word = data.load(std::memory_order_relaxed);
+
+        // the first listener goes straight into the word.
+        if (!word) {
+            l._slot = 0;
+            replace_list(reinterpret_cast<std::uintptr_t>(&l) | single_tag);
+            return;
+        }
+
+        auto current = current_array(word);
+        l._slot = generator.get_size(current);
+        publish(generator.copy_push_back(current, l));
     }
 
     template<typename... Params>
     void event_base<Params...>::repudiate(listener_base<Params...>& l) {
-        replace_data_using([&](const auto& arr) {
-            return generator.copy_remove(arr, l);
+        unlink(l);
+        wait_for_unlinked(l);
+    }
+
+    template<typename... Params>
+    void event_base<Params...>::wait_for_unlinked(listener_base<Params...>& l) {
+        wait_for_readers([&l](epoch_domain::frame& f, bool own) {
+            if (!own && f.current == &l)
+                return false;
+
+            std::for_each_n(static_cast<entry_type*>(f.first), f.size, [&l](auto& entry) {
+                if (generator_type::load_entry(entry) == &l)
+                    generator_type::tombstone(entry);
+            });
+            return true;
         });
     }
 
     template<typename... Params>
-    void event_base<Params...>::clear() {
-        auto holder = lock();
+    void event_base<Params...>::unlink(listener_base<Params...>& l) {
+        auto lock_guard = lock_writers();
+        auto word = data.load(std::memory_order_relaxed);
+
+        if (!is_array(word)) {
+            if (word && as_single(word) == &l) {
+                replace_list(0);
+                return;
+            }
+            write_count++;
+            write_count.notify_all();
+            return;
+        }
+
+        auto& holder = as_array(word);
+        auto first = generator.get_data(holder);
         auto size = generator.get_size(holder);
 
-        auto removed = 0;
-        std::for_each_n(generator.get_data(holder), generator.get_size(holder),[&removed](auto l){
-            if (l->detatch())
-                removed++;
+        auto slot = l._slot < size && first[l._slot].listener == &l
+            ? std::next(first, l._slot)
+            : std::find_if(first, std::next(first, size), [&l](auto& entry) { return entry.listener == &l; });
+
+        if (slot != std::next(first, size)) {
+            generator_type::tombstone(*slot);
+            tombstones++;
+        }
+
+        if (tombstones == size - 1) {
+            // down to one listener, it goes back into the word without a new array.
+            auto live = std::find_if(first, std::next(first, size), [](auto& entry) { return entry.listener != nullptr; })->listener;
+            live->_slot = 0;
+            replace_list(reinterpret_cast<std::uintptr_t>(live) | single_tag);
+            tombstones = 0;
+        }
+        else if (tombstones * compact_ratio > size) {
+            publish(generator.copy_compact(holder));
+            tombstones = 0;
+            update_slots();
+        }
+        else {
+            write_count++;
+            write_count.notify_all();
+        }
+    }
+
+    template<typename... Params>
+    template<typename AddRange, typename RemoveRange>
+    void event_base<Params...>::update(const AddRange& added, const RemoveRange& removed) {
+        {
+            auto lock_guard = lock_writers();
+            publish(generator.copy_update(current_array(data.load(std::memory_order_relaxed)), added, removed));
+            tombstones = 0;
+            update_slots();
+        }
+
+        if (std::begin(removed) == std::end(removed))
+            return;
+
+        auto is_removed = [&removed](const listener_type* l) {
+            return std::binary_search(std::begin(removed), std::end(removed), l);
+        };
+
+        wait_for_readers([&is_removed](epoch_domain::frame& f, bool own) {
+            if (!own && f.current && is_removed(static_cast<const listener_type*>(f.current)))
+                return false;
+
+            std::for_each_n(static_cast<entry_type*>(f.first), f.size, [&is_removed](auto& entry) {
+                if (auto l = generator_type::load_entry(entry); l && is_removed(l))
+                    generator_type::tombstone(entry);
+            });
+            return true;
         });
+    }
+
+    template<typename... Params>
+    void event_base<Params...>::clear() {
+        auto removed = std::size_t{ 0 };
+        {
+            // scoped, listeners that are repudiating themselves wait before going away.
+            auto guard = domain.read_lock(this);
+            auto single = entry_type{};
+            auto [first, size] = entries(data.load(std::memory_order_acquire), single);
+            std::for_each_n(first, size, [&removed](auto& entry) {
+                auto l = generator_type::load_entry(entry);
+                if (l && l->detatch())
+                    removed++;
+            });
+        }
+
+        RPT_TRACE2(clear, trace_address(this), removed);
+
+        // listeners that could not be detached are part way through repudiating themselves.
+        wait_on_listener_count(removed);
+
+        // the last of them may still be holding write_mutex.
+        {
+            auto lock_guard = std::lock_guard{ write_mutex };
+        }
 
-        auto generatrion = generator.get_generation(holder);
-        holder = nullptr;
+        wait_for_readers();
+    }
 
-        wait_on_generatrion_equal(generatrion);
+    template<typename... Params>
+    event_metrics event_base<Params...>::metrics() const {
+        auto output = recorder.snapshot();
+        if (output.enabled) {
+            auto guard = domain.read_lock();
+            auto single = entry_type{};
+            auto [first, size] = entries(data.load(std::memory_order_acquire), single);
+            output.listeners = static_cast<std::size_t>(std::count_if(first, std::next(first, size), [](auto& entry) {
+                return generator_type::load_entry(entry) != nullptr;
+            }));
+        }
+        return output;
+    }
 
-        //data.store(nullptr);
+    template<typename... Params>
+    void event_base<Params...>::wait_for_readers() {
+        wait_for_readers([](epoch_domain::frame&, bool) { return false; });
+    }
+
+    template<typename... Params>
+    template<typename Forget>
+    void event_base<Params...>::wait_for_readers(Forget&& forget) {
+        auto start = recorder.now();
+        RPT_TRACE1(reader_wait_begin, trace_address(this));
+        domain.synchronize(this, forget);
+        RPT_TRACE1(reader_wait_end, trace_address(this));
+        recorder.waited(start);
+    }
+
+    template<typename... Params>
+    std::unique_lock<std::mutex> event_base<Params...>::lock_writers() {
+        if constexpr (std::is_same_v<recorder_type, metrics_recorder>) {
+            auto lock = std::unique_lock{ write_mutex, std::try_to_lock };
+            if (!lock.owns_lock()) {
+                recorder.write_waited();
+                lock.lock();
+            }
+            return lock;
+        }
+        else {
+            return std::unique_lock{ write_mutex };
+        }
     }
 }
 
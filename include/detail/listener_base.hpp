@@ -5,6 +5,10 @@
 #ifndef RPT_DETAIL_LISTENER_BASE
 #define RPT_DETAIL_LISTENER_BASE
 
+#include "entry_traits.hpp"
+#include "param_traits.hpp"
+
+#include <cstddef>
 #include <memory>
 
 namespace rpt::event_detail {
@@ -13,23 +17,46 @@ namespace rpt::event_detail {
     */
     template<typename... Params>
     struct listener_base {
-        using callback_ref_type = void(*)(listener_base&, Params...);
+        using callback_ref_type = void(*)(listener_base&, param_t<Params>...);
         using detach_type = bool(*)(listener_base&);
 
         callback_ref_type _callback;
 
         detach_type _detatch;
 
+        // index of the listener in the current array, only a hint and only touched by writers.
+        std::size_t _slot{ 0 };
+
         template<typename... Args>
-        void operator()(Args...);
+        void operator()(Args&&...);
 
         bool detatch();
     };
 
+    /*
+    *   entry of an event's listener array, the callback is copied next to the listener so
+    *   a dispatch streams through the array instead of loading it from every listener.
+    *   listener is the key, a tombstone has it set to nullptr.
+    */
+    template<typename... Params>
+    struct dispatch_entry {
+        typename listener_base<Params...>::callback_ref_type callback;
+        listener_base<Params...>* listener;
+    };
+
+    template<typename... Params>
+    struct entry_traits<dispatch_entry<Params...>> {
+        using pointer = listener_base<Params...>*;
+
+        static dispatch_entry<Params...> make(pointer p) { return { p->_callback, p }; }
+        static pointer& key(dispatch_entry<Params...>& e) { return e.listener; }
+        static pointer key(const dispatch_entry<Params...>& e) { return e.listener; }
+    };
+
     template<typename... Params>
     template<typename... Args>
-    void listener_base<Params...>::operator()(Args... args) {
-        _callback(*this, Params(std::move(args))...);
+    void listener_base<Params...>::operator()(Args&&... args) {
+        _callback(*this, forward_param<Params>(std::forward<Args>(args))...);
     }
 
     template<typename... Params>
@@ -0,0 +1,205 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#ifndef RPT_DETAIL_METRICS_RECORDER
+#define RPT_DETAIL_METRICS_RECORDER
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+/*
+    define RPT_ENABLE_METRICS to 1 (the RPT_ENABLE_METRICS cmake option) to have every event
+    keep the counters below, otherwise they compile away.
+*/
+#ifndef RPT_ENABLE_METRICS
+#define RPT_ENABLE_METRICS 0
+#endif
+
+namespace rpt {
+
+    /*
+    *   counters of one event, see event::metrics. all zero when metrics are compiled out.
+    */
+    struct event_metrics {
+        static constexpr std::size_t latency_bucket_count = 16;
+
+        /*
+            upper bound of latency bucket i, they double from 128ns to about 2ms. the last
+            bucket has no bound, it takes everything slower.
+        */
+        static constexpr std::chrono::nanoseconds latency_bound(std::size_t i) {
+            return std::chrono::nanoseconds{ std::int64_t{ 128 } << i };
+        }
+
+        bool enabled{ false };
+
+        std::uint64_t dispatches{ 0 };
+
+        // listeners subscribed when the snapshot was taken.
+        std::size_t listeners{ 0 };
+
+        // listener lists published, and how often a writer found write_mutex taken. writers
+        // are serialized by that mutex, the list word itself is only ever exchanged.
+        std::uint64_t list_writes{ 0 };
+        std::uint64_t write_lock_waits{ 0 };
+
+        // listener arrays allocated, handed to the epoch domain once replaced, and freed
+        // once the domain reclaims them. retired arrays not freed yet wait for readers.
+        std::uint64_t arrays_allocated{ 0 };
+        std::uint64_t arrays_retired{ 0 };
+        std::uint64_t arrays_freed{ 0 };
+
+        // unsubscribes and clears that waited for running dispatches, and how long for.
+        std::uint64_t reader_waits{ 0 };
+        std::chrono::nanoseconds reader_wait_time{ 0 };
+
+        // dispatches by duration, not cumulative.
+        std::array<std::uint64_t, latency_bucket_count> dispatch_latency{};
+        std::chrono::nanoseconds dispatch_time{ 0 };
+    };
+}
+
+namespace rpt::event_detail {
+
+    /*
+    *   counters kept by an event when metrics are compiled in, relaxed atomics bumped on
+    *   the paths they count.
+    */
+    class metrics_recorder {
+        struct reclaim_counter {
+            std::atomic<std::uint64_t> arrays_freed{ 0 };
+        };
+
+    public:
+        using clock_type = std::chrono::steady_clock;
+        using time_point = clock_type::time_point;
+
+        /*
+            kept by each array until it is freed, which may be after the event is gone.
+        */
+        using array_token = std::shared_ptr<reclaim_counter>;
+
+        static time_point now();
+
+        void dispatched(time_point start);
+        void written();
+        void write_waited();
+        array_token array_allocated();
+        void array_retired();
+        static void array_freed(const array_token&);
+        void waited(time_point start);
+
+        /*
+            everything but the listener count, which the event fills in.
+        */
+        event_metrics snapshot() const;
+
+    private:
+        static std::size_t bucket_of(std::chrono::nanoseconds);
+
+        std::atomic<std::uint64_t> dispatches{ 0 };
+        std::atomic<std::uint64_t> list_writes{ 0 };
+        std::atomic<std::uint64_t> write_lock_waits{ 0 };
+        std::atomic<std::uint64_t> arrays_allocated{ 0 };
+        std::atomic<std::uint64_t> arrays_retired{ 0 };
+        array_token reclaimed{ std::make_shared<reclaim_counter>() };
+        std::atomic<std::uint64_t> reader_waits{ 0 };
+        std::atomic<std::int64_t> reader_wait_ns{ 0 };
+        std::array<std::atomic<std::uint64_t>, event_metrics::latency_bucket_count> dispatch_latency{};
+        std::atomic<std::int64_t> dispatch_ns{ 0 };
+    };
+
+    /*
+    *   stand in for metrics_recorder when metrics are compiled out, every call is empty.
+    */
+    class null_recorder {
+    public:
+        struct time_point {};
+        struct array_token {};
+
+        static time_point now() { return {}; }
+
+        void dispatched(time_point) {}
+        void written() {}
+        void write_waited() {}
+        array_token array_allocated() { return {}; }
+        void array_retired() {}
+        static void array_freed(const array_token&) {}
+        void waited(time_point) {}
+
+        event_metrics snapshot() const { return {}; }
+    };
+
+    using recorder_type = std::conditional_t<RPT_ENABLE_METRICS != 0, metrics_recorder, null_recorder>;
+
+    inline metrics_recorder::time_point metrics_recorder::now() {
+        return clock_type::now();
+    }
+
+    inline void metrics_recorder::dispatched(time_point start) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now() - start);
+        dispatches.fetch_add(1, std::memory_order_relaxed);
+        dispatch_latency[bucket_of(elapsed)].fetch_add(1, std::memory_order_relaxed);
+        dispatch_ns.fetch_add(elapsed.count(), std::memory_order_relaxed);
+    }
+
+    inline void metrics_recorder::written() {
+        list_writes.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    inline void metrics_recorder::write_waited() {
+        write_lock_waits.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    inline metrics_recorder::array_token metrics_recorder::array_allocated() {
+        arrays_allocated.fetch_add(1, std::memory_order_relaxed);
+        return reclaimed;
+    }
+
+    inline void metrics_recorder::array_retired() {
+        arrays_retired.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    inline void metrics_recorder::array_freed(const array_token& token) {
+        token->arrays_freed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    inline void metrics_recorder::waited(time_point start) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now() - start);
+        reader_waits.fetch_add(1, std::memory_order_relaxed);
+        reader_wait_ns.fetch_add(elapsed.count(), std::memory_order_relaxed);
+    }
+
+    inline event_metrics metrics_recorder::snapshot() const {
+        auto output = event_metrics{};
+        output.enabled = true;
+        output.dispatches = dispatches.load(std::memory_order_relaxed);
+        output.list_writes = list_writes.load(std::memory_order_relaxed);
+        output.write_lock_waits = write_lock_waits.load(std::memory_order_relaxed);
+        output.arrays_allocated = arrays_allocated.load(std::memory_order_relaxed);
+        output.arrays_retired = arrays_retired.load(std::memory_order_relaxed);
+        output.arrays_freed = reclaimed->arrays_freed.load(std::memory_order_relaxed);
+        output.reader_waits = reader_waits.load(std::memory_order_relaxed);
+        output.reader_wait_time = std::chrono::nanoseconds{ reader_wait_ns.load(std::memory_order_relaxed) };
+        for (auto i = std::size_t{ 0 }; i < event_metrics::latency_bucket_count; i++)
+            output.dispatch_latency[i] = dispatch_latency[i].load(std::memory_order_relaxed);
+        output.dispatch_time = std::chrono::nanoseconds{ dispatch_ns.load(std::memory_order_relaxed) };
+        return output;
+    }
+
+    inline std::size_t metrics_recorder::bucket_of(std::chrono::nanoseconds elapsed) {
+        // bucket i holds durations up to 128ns << i.
+        auto scaled = static_cast<std::uint64_t>(std::max<std::int64_t>(elapsed.count() - 1, 0)) >> 7;
+        return std::min<std::size_t>(static_cast<std::size_t>(std::bit_width(scaled)), event_metrics::latency_bucket_count - 1);
+    }
+}
+
+#endif // RPT_DETAIL_METRICS_RECORDER
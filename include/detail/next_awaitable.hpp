@@ -0,0 +1,135 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#ifndef RPT_DETAIL_NEXT_AWAITABLE
+#define RPT_DETAIL_NEXT_AWAITABLE
+
+#if defined(__cpp_impl_coroutine)
+
+#include "epoch_domain.hpp"
+#include "event_base.hpp"
+#include "listener_base.hpp"
+#include "param_traits.hpp"
+
+#include <atomic>
+#include <coroutine>
+#include <memory_resource>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+
+namespace rpt::event_detail {
+
+    /*
+    *   awaiter for the next dispatch of an event, resumes the coroutine on the dispatching
+    *   thread with a copy of the arguments.
+    *
+    *   the coroutine is subscribed through a one shot listener_base node allocated from the
+    *   event's memory resource. dispatches that lose the race to fire it still touch the
+    *   node, so it is unlinked without waiting and retired to the epoch domain through a
+    *   link of its own instead of being freed in place.
+    */
+    template<typename... Params>
+    class next_awaitable {
+    public:
+        using result_type = std::tuple<std::remove_cvref_t<Params>...>;
+
+        explicit next_awaitable(event_base<Params...>&);
+
+        next_awaitable(const next_awaitable&) = delete;
+        next_awaitable& operator=(const next_awaitable&) = delete;
+
+        ~next_awaitable();
+
+        bool await_ready() const noexcept;
+        void await_suspend(std::coroutine_handle<>);
+        result_type await_resume();
+
+    private:
+        struct node : listener_base<Params...>, epoch_domain::retired {
+            node(next_awaitable&, std::pmr::memory_resource*);
+
+            static void destroy(epoch_domain::retired&);
+
+            next_awaitable& awaiter;
+            std::atomic<bool> fired{ false };
+            std::pmr::memory_resource* resource;
+        };
+
+        event_base<Params...>& event_base_ref;
+        node* registered{ nullptr };
+        std::coroutine_handle<> handle;
+        std::optional<result_type> result;
+    };
+
+    template<typename... Params>
+    next_awaitable<Params...>::node::node(next_awaitable& awaiter, std::pmr::memory_resource* resource)
+        : listener_base<Params...>{
+            [](listener_base<Params...>& base, param_t<Params>... params) {
+                auto& self = static_cast<node&>(base);
+                if (self.fired.exchange(true))
+                    return;
+
+                auto& awaiter = self.awaiter;
+                awaiter.result.emplace(params...);
+                awaiter.event_base_ref.unlink(self);
+                awaiter.handle.resume();
+            },
+            [](listener_base<Params...>& base) {
+                return !static_cast<node&>(base).fired.exchange(true);
+            } }
+        , awaiter{ awaiter }
+        , resource{ resource }
+    {
+        deleter = &destroy;
+    }
+
+    template<typename... Params>
+    void next_awaitable<Params...>::node::destroy(epoch_domain::retired& r) {
+        auto& self = static_cast<node&>(r);
+        std::pmr::polymorphic_allocator<node>{ self.resource }.delete_object(&self);
+    }
+
+    template<typename... Params>
+    next_awaitable<Params...>::next_awaitable(event_base<Params...>& event_base_ref)
+        : event_base_ref{ event_base_ref }
+    {}
+
+    template<typename... Params>
+    next_awaitable<Params...>::~next_awaitable() {
+        if (!registered)
+            return;
+
+        // still subscribed if the coroutine is destroyed before the event fires,
+        // once fired or cleared the event is never touched again.
+        if (!registered->fired.exchange(true))
+            event_base_ref.unlink(*registered);
+
+        epoch_domain::instance().retire(static_cast<epoch_domain::retired&>(*registered));
+    }
+
+    template<typename... Params>
+    bool next_awaitable<Params...>::await_ready() const noexcept {
+        return false;
+    }
+
+    template<typename... Params>
+    void next_awaitable<Params...>::await_suspend(std::coroutine_handle<> h) {
+        handle = h;
+        auto* resource = event_base_ref.get_allocator().resource();
+        registered = std::pmr::polymorphic_allocator<node>{ resource }.template new_object<node>(*this, resource);
+
+        // the coroutine can be resumed on another thread from here on, *this must not be touched.
+        event_base_ref.subscribe(*registered);
+    }
+
+    template<typename... Params>
+    typename next_awaitable<Params...>::result_type next_awaitable<Params...>::await_resume() {
+        return std::move(*result);
+    }
+}
+
+#endif // defined(__cpp_impl_coroutine)
+
+#endif // RPT_DETAIL_NEXT_AWAITABLE
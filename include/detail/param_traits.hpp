@@ -0,0 +1,42 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#ifndef RPT_DETAIL_PARAM_TRAITS
+#define RPT_DETAIL_PARAM_TRAITS
+
+#include <type_traits>
+#include <utility>
+
+namespace rpt::event_detail {
+
+    /*
+    *   how a dispatch argument of type T is handed to every listener.
+    *
+    *   small trivially copyable values go by value, everything else by const reference
+    *   so the payload is only materialised once per dispatch. reference parameters are
+    *   passed through unchanged. specialise to override the choice for a type.
+    */
+    template<typename T>
+    struct param_traits {
+        using type = std::conditional_t<std::is_trivially_copyable_v<T> && sizeof(T) <= 2 * sizeof(void*), T, const T&>;
+    };
+
+    template<typename T>
+    using param_t = typename param_traits<T>::type;
+
+    /*
+        pass arg through when it already converts to param_t<P>, otherwise construct a P
+        from it explicitly. either way the conversion happens in the caller's expression
+        so any temporary lives for the whole dispatch.
+    */
+    template<typename P, typename Arg>
+    constexpr decltype(auto) forward_param(Arg&& arg) {
+        if constexpr (std::is_convertible_v<Arg&&, param_t<P>>)
+            return std::forward<Arg>(arg);
+        else
+            return P(std::forward<Arg>(arg));
+    }
+}
+
+#endif // RPT_DETAIL_PARAM_TRAITS
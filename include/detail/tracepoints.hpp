@@ -0,0 +1,127 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#ifndef RPT_DETAIL_TRACEPOINTS
+#define RPT_DETAIL_TRACEPOINTS
+
+#include <cstdint>
+
+/*
+    USDT probes under the provider "rpt" for perf, bpftrace and systemtap, e.g.
+
+        bpftrace -e 'usdt:./app:rpt:dispatch_begin { @[arg0] = count(); }'
+
+    a probe is a nop plus an ELF note (.note.stapsdt) describing where its arguments
+    live, laid out the way sys/sdt.h lays it out so no tracing headers are needed. every
+    probe has a semaphore in .probes that tracers raise while attached, the nop and the
+    argument computation are skipped unless it is raised (RPT_TRACE_ENABLED is the
+    check, like sys/sdt.h's _ENABLED macros). every argument is passed as a 64 bit value.
+
+        dispatch_begin, dispatch_end        event, slots
+        list_publish                        event, generation, slots
+        reader_wait_begin, reader_wait_end  event
+        clear                               event, detached
+        reclaim                             epoch, freed
+
+    slots counts the entries of the listener list, including ones already cleared that a
+    later write compacts away. on by default where the note can be emitted (ELF x86-64
+    and aarch64 with gcc or clang), define RPT_ENABLE_TRACEPOINTS to 0 (the
+    RPT_ENABLE_TRACEPOINTS cmake option) to leave them out altogether.
+*/
+#ifndef RPT_ENABLE_TRACEPOINTS
+#if defined(__ELF__) && (defined(__x86_64__) || defined(__aarch64__)) && defined(__GNUC__)
+#define RPT_ENABLE_TRACEPOINTS 1
+#else
+#define RPT_ENABLE_TRACEPOINTS 0
+#endif
+#endif
+
+#if RPT_ENABLE_TRACEPOINTS
+
+#define RPT_DETAIL_PROBE_ASM(name, args)                                        \
+    "990: nop\n"                                                                \
+    ".pushsection .note.stapsdt,\"?\",\"note\"\n"                               \
+    ".balign 4\n"                                                               \
+    ".4byte 992f-991f, 994f-993f, 3\n"                                          \
+    "991: .asciz \"stapsdt\"\n"                                                 \
+    "992: .balign 4\n"                                                          \
+    "993: .8byte 990b\n"                                                        \
+    ".8byte _.stapsdt.base\n"                                                   \
+    ".8byte rpt_" #name "_semaphore\n"                                          \
+    ".asciz \"rpt\"\n"                                                          \
+    ".asciz \"" #name "\"\n"                                                    \
+    ".asciz \"" args "\"\n"                                                     \
+    "994: .balign 4\n"                                                          \
+    ".popsection\n"                                                             \
+    ".ifndef _.stapsdt.base\n"                                                  \
+    ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n"     \
+    ".weak _.stapsdt.base\n"                                                    \
+    ".hidden _.stapsdt.base\n"                                                  \
+    "_.stapsdt.base: .space 1\n"                                                \
+    ".size _.stapsdt.base, 1\n"                                                 \
+    ".popsection\n"                                                             \
+    ".endif\n"
+
+#define RPT_DETAIL_PROBE_ARG(a) "nor"(static_cast<std::uint64_t>(a))
+
+// inline, so every translation unit shares one semaphore per probe.
+#define RPT_DETAIL_PROBE_SEMAPHORE(name)                                        \
+    extern "C" {                                                                \
+        __attribute__((section(".probes"), used))                               \
+        inline volatile unsigned short rpt_##name##_semaphore = 0;              \
+    }
+
+RPT_DETAIL_PROBE_SEMAPHORE(dispatch_begin)
+RPT_DETAIL_PROBE_SEMAPHORE(dispatch_end)
+RPT_DETAIL_PROBE_SEMAPHORE(list_publish)
+RPT_DETAIL_PROBE_SEMAPHORE(reader_wait_begin)
+RPT_DETAIL_PROBE_SEMAPHORE(reader_wait_end)
+RPT_DETAIL_PROBE_SEMAPHORE(clear)
+RPT_DETAIL_PROBE_SEMAPHORE(reclaim)
+
+#define RPT_TRACE_ENABLED(name) __builtin_expect(rpt_##name##_semaphore != 0, 0)
+
+#define RPT_TRACE1(name, a)                                                     \
+    do {                                                                        \
+        if (RPT_TRACE_ENABLED(name))                                            \
+            __asm__ __volatile__(RPT_DETAIL_PROBE_ASM(name, "8@%0")             \
+                :: RPT_DETAIL_PROBE_ARG(a));                                    \
+    } while (false)
+
+#define RPT_TRACE2(name, a, b)                                                  \
+    do {                                                                        \
+        if (RPT_TRACE_ENABLED(name))                                            \
+            __asm__ __volatile__(RPT_DETAIL_PROBE_ASM(name, "8@%0 8@%1")        \
+                :: RPT_DETAIL_PROBE_ARG(a), RPT_DETAIL_PROBE_ARG(b));           \
+    } while (false)
+
+#define RPT_TRACE3(name, a, b, c)                                               \
+    do {                                                                        \
+        if (RPT_TRACE_ENABLED(name))                                            \
+            __asm__ __volatile__(RPT_DETAIL_PROBE_ASM(name, "8@%0 8@%1 8@%2")   \
+                :: RPT_DETAIL_PROBE_ARG(a), RPT_DETAIL_PROBE_ARG(b),            \
+                    RPT_DETAIL_PROBE_ARG(c));                                   \
+    } while (false)
+
+#else
+
+// the arguments are not evaluated.
+#define RPT_TRACE_ENABLED(name) false
+#define RPT_TRACE1(name, a) ((void)0)
+#define RPT_TRACE2(name, a, b) ((void)0)
+#define RPT_TRACE3(name, a, b, c) ((void)0)
+
+#endif
+
+namespace rpt::event_detail {
+
+    /*
+        probe argument for a pointer.
+    */
+    inline std::uint64_t trace_address(const void* p) {
+        return static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(p));
+    }
+}
+
+#endif // RPT_DETAIL_TRACEPOINTS
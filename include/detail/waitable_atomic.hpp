@@ -6,10 +6,48 @@
 #define RPT_DETAIL_WAITABLE_ATOMIC
 
 #include <atomic>
+#include <climits>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+// only what WaitOnAddress needs, and no min and max macros for anyone including this.
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#define RPT_DETAIL_UNDEF_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#define RPT_DETAIL_UNDEF_NOMINMAX
+#endif
+#include <Windows.h>
+#ifdef RPT_DETAIL_UNDEF_LEAN_AND_MEAN
+#undef WIN32_LEAN_AND_MEAN
+#undef RPT_DETAIL_UNDEF_LEAN_AND_MEAN
+#endif
+#ifdef RPT_DETAIL_UNDEF_NOMINMAX
+#undef NOMINMAX
+#undef RPT_DETAIL_UNDEF_NOMINMAX
+#endif
+#else
 #include <condition_variable>
+#include <mutex>
+#endif
 
 namespace rpt::event_detail {
 
+    /*
+    *   atomic that can be waited on for a change of value.
+    *
+    *   waiters park on a 32 bit sequence word with the platform wait on address primitive
+    *   (futex on linux), notify_all only bumps the sequence and enters the kernel when
+    *   a waiter has registered itself.
+    */
     template<typename T>
     class waitable_atomic {
     public:
@@ -17,15 +55,22 @@ namespace rpt::event_detail {
         void store(T desired, std::memory_order order = std::memory_order_seq_cst) noexcept;
         T load(std::memory_order order = std::memory_order_seq_cst) const noexcept;
         T operator++(int) noexcept;
-        void notify_all();// noexcept;
-        void wait(T old, std::memory_order order = std::memory_order_seq_cst) const;// noexcept;
+        T operator--(int) noexcept;
+        void notify_all() noexcept;
+        void wait(T old, std::memory_order order = std::memory_order_seq_cst) const noexcept;
 
     private:
-        void lock_unlock(); //force single point synchronisation 
+        void park(std::uint32_t sequence) const noexcept;
+        void wake_all() noexcept;
 
         std::atomic<T> atom;
+        mutable std::atomic<std::uint32_t> waiters{ 0 };
+        mutable std::atomic<std::uint32_t> sequence{ 0 };
+
+#if !defined(__linux__) && !defined(_WIN32)
         mutable std::condition_variable cv;
         mutable std::mutex mtx;
+#endif
     };
 
     template<typename T>
@@ -35,7 +80,7 @@ namespace rpt::event_detail {
 
     template<typename T>
     void waitable_atomic<T>::store(T desired, std::memory_order order) noexcept {
-        atom.store(std:move(desired), order);
+        atom.store(std::move(desired), order);
     }
 
     template<typename T>
@@ -50,25 +95,78 @@ namespace rpt::event_detail {
     }
 
     template<typename T>
-    void waitable_atomic<T>::notify_all() {
-        lock_unlock();
-        cv.notify_all();
+    T waitable_atomic<T>::operator--(int) noexcept {
+        static_assert(std::is_integral_v<T>);
+        return atom--;
+    }
+
+    template<typename T>
+    void waitable_atomic<T>::notify_all() noexcept {
+        // pairs with the increment in wait, either the waiter sees the new value or we see the waiter.
+        if (waiters.load() == 0)
+            return;
+
+        sequence++;
+        wake_all();
+    }
+
+    template<typename T>
+    void waitable_atomic<T>::wait(T old, std::memory_order order) const noexcept {
+        if (atom.load(order) != old)
+            return;
+
+        waiters++;
+        while (true) {
+            auto current_sequence = sequence.load();
+            if (atom.load(order) != old)
+                break;
+            park(current_sequence);
+        }
+        waiters--;
+    }
+
+#if defined(__linux__)
+
+    template<typename T>
+    void waitable_atomic<T>::park(std::uint32_t current_sequence) const noexcept {
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&sequence), FUTEX_WAIT_PRIVATE, current_sequence, nullptr, nullptr, 0);
+    }
+
+    template<typename T>
+    void waitable_atomic<T>::wake_all() noexcept {
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&sequence), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
     }
 
+#elif defined(_WIN32)
+
     template<typename T>
-    void waitable_atomic<T>::lock_unlock()
-    {
-        auto lock = std::lock_guard{ mtx };
+    void waitable_atomic<T>::park(std::uint32_t current_sequence) const noexcept {
+        WaitOnAddress(const_cast<std::atomic<std::uint32_t>*>(&sequence), &current_sequence, sizeof(current_sequence), INFINITE);
     }
 
     template<typename T>
-    void waitable_atomic<T>::wait(T old, std::memory_order order) const {
-        if (atom.load(order) != old) {
-            auto lock = std::unique_lock{ mtx };
-            cv.wait(lock, [&] { return atom.load(order) != old; });
+    void waitable_atomic<T>::wake_all() noexcept {
+        WakeByAddressAll(&sequence);
+    }
+
+#else
+
+    template<typename T>
+    void waitable_atomic<T>::park(std::uint32_t current_sequence) const noexcept {
+        auto lock = std::unique_lock{ mtx };
+        cv.wait(lock, [&] { return sequence.load() != current_sequence; });
+    }
+
+    template<typename T>
+    void waitable_atomic<T>::wake_all() noexcept {
+        {
+            auto lock = std::lock_guard{ mtx };
         }
+        cv.notify_all();
     }
 
+#endif
+
 }
 
-#endif // RPT_DETAIL_WAITABLE_ATOMIC
\ No newline at end of file
+#endif // RPT_DETAIL_WAITABLE_ATOMIC
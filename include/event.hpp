@@ -5,13 +5,32 @@
 #ifndef RPT_EVENT
 #define RPT_EVENT
 
+#include "detail/connection_node.hpp"
 #include "detail/event_base.hpp"
+#include "detail/next_awaitable.hpp"
+#include "completion.hpp"
+#include "connection.hpp"
+#include "executor.hpp"
 #include "listener.hpp"
+#include "pool_resource.hpp"
 
-#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <tuple>
+#include <type_traits>
 
 namespace rpt {
 
+    /*
+    *   how event::fan_out splits a dispatch, events with fewer than sequential_threshold
+    *   listeners are dispatched on the calling thread.
+    */
+    struct fan_out_options {
+        std::size_t grain_size{ 1024 };
+        std::size_t sequential_threshold{ 4096 };
+    };
+
     template<typename... Params>
     class event : event_detail::event_base<Params...>{
     public:
@@ -19,7 +38,10 @@ namespace rpt {
 
         using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
 
-        event() = default;
+        /*
+            allocates its listener arrays from pool_resource::instance().
+        */
+        event();
         event(const event&) = delete;
         event(event&&) = delete;
 
@@ -38,19 +60,79 @@ namespace rpt {
 
         template<typename... Args>
         void operator()(Args&&... args) {
-            base_type::operator()(std::move(args)...);
+            base_type::operator()(event_detail::forward_param<Params>(std::forward<Args>(args))...);
         }
 
+        /*
+        * dispatch on an executor instead of the calling thread.
+        * the listeners are the ones subscribed when the dispatch runs, a listener may
+        * unsubscribe or destroy itself from a posted dispatch like from any other. arguments
+        * are stored until then, reference parameters must outlive the dispatch. the event
+        * waits for posted dispatches that have not run yet when it is destroyed.
+        */
+        template<typename... Args>
+        completion post(Args&&... args);
+
+        template<typename... Args>
+        completion post(executor&, Args&&... args);
+
+        /*
+        * dispatch with the listeners split into chunks that run in parallel on an executor,
+        * the calling thread takes chunks as well. returns once every listener has been called.
+        */
+        template<typename... Args>
+        void fan_out(const fan_out_options&, Args&&... args);
+
+        template<typename... Args>
+        void fan_out(executor&, const fan_out_options&, Args&&... args);
+
         template<typename Callback>
         listener<Callback, Params...> subscribe(Callback&&);
+
+        /*
+        * subscribe cb and return a movable handle to the subscription, the callback is
+        * stored in a node from pool_resource::instance(). wrap it in a scoped_connection to
+        * unsubscribe when the handle goes away.
+        */
+        template<typename Callback>
+        connection connect(Callback&&);
+
+        /*
+        * connect cb for the next dispatch only, it is unsubscribed by the dispatch that
+        * calls it without waiting for anything. the connection can still be used to cancel
+        * it before then.
+        */
+        template<typename Callback>
+        connection subscribe_once(Callback&&);
+
+        /*
+        * counters for this event, they are only kept when built with RPT_ENABLE_METRICS
+        * and are all zero otherwise. event_metrics.hpp writes them out for prometheus.
+        */
+        event_metrics metrics() const;
+
+#if defined(__cpp_impl_coroutine)
+        /*
+        * co_await e.next() suspends until the next dispatch and evaluates to a tuple of
+        * copies of its arguments. the coroutine is resumed on the dispatching thread,
+        * inside the dispatch. if the event is destroyed first it is never resumed.
+        */
+        event_detail::next_awaitable<Params...> next();
+#endif
     private:
         friend event_detail::get_event_base<Params...>;
 
         using base_type = event_detail::event_base<Params...>;
 
-        std::atomic_uintptr_t invokers{ 0 };
+        // dispatches posted and not yet finished.
+        event_detail::waitable_atomic<std::uint64_t> posted{ 0 };
     };
 
+    template<typename... Params>
+    event<Params...>::event()
+        : event{ allocator_type{ &pool_resource::instance() } }
+    {}
+
     template<typename... Params>
     template<typename Callback>
     listener<Callback, Params...> event<Params...>::subscribe(Callback&& cb) {
@@ -58,9 +140,89 @@ namespace rpt {
     }
 
 
+    template<typename... Params>
+    template<typename Callback>
+    connection event<Params...>::connect(Callback&& cb) {
+        using node_type = event_detail::connection_node<std::decay_t<Callback>, Params...>;
+        return connection{ node_type::make(*this, std::forward<Callback>(cb), &pool_resource::instance()) };
+    }
+
+    template<typename... Params>
+    template<typename Callback>
+    connection event<Params...>::subscribe_once(Callback&& cb) {
+        using node_type = event_detail::connection_node<std::decay_t<Callback>, Params...>;
+        return connection{ node_type::make(*this, std::forward<Callback>(cb), &pool_resource::instance(), true) };
+    }
+
+    template<typename... Params>
+    template<typename... Args>
+    completion event<Params...>::post(Args&&... args) {
+        return post(executor::instance(), std::forward<Args>(args)...);
+    }
+
+    template<typename... Params>
+    template<typename... Args>
+    completion event<Params...>::post(executor& ex, Args&&... args) {
+        struct post_state : event_detail::completion_state {
+            explicit post_state(Args&&... args)
+                : params{ std::forward<Args>(args)... }
+            {}
+
+            std::tuple<Params...> params;
+        };
+
+        auto state = std::make_shared<post_state>(std::forward<Args>(args)...);
+
+        posted++;
+        ex.submit([this, state]() {
+            {
+                // the destructor waits for posted and then for this section, so posted is
+                // still alive when it is notified.
+                auto guard = event_detail::epoch_domain::instance().read_lock(static_cast<base_type*>(this));
+                std::apply([this](auto&... params) {
+                    (*this)(params...);
+                }, state->params);
+
+                posted--;
+                posted.notify_all();
+            }
+            state->complete();
+        });
+
+        return completion{ std::move(state) };
+    }
+
+    template<typename... Params>
+    template<typename... Args>
+    void event<Params...>::fan_out(const fan_out_options& options, Args&&... args) {
+        fan_out(executor::instance(), options, std::forward<Args>(args)...);
+    }
+
+    template<typename... Params>
+    template<typename... Args>
+    void event<Params...>::fan_out(executor& ex, const fan_out_options& options, Args&&... args) {
+        base_type::fan_out(ex, options.grain_size, options.sequential_threshold,
+            event_detail::forward_param<Params>(std::forward<Args>(args))...);
+    }
+
+    template<typename... Params>
+    event_metrics event<Params...>::metrics() const {
+        return base_type::metrics();
+    }
+
+#if defined(__cpp_impl_coroutine)
+    template<typename... Params>
+    event_detail::next_awaitable<Params...> event<Params...>::next() {
+        return event_detail::next_awaitable<Params...>{ *this };
+    }
+#endif
+
     template<typename... Params>
     event<Params...>::~event() {
-        event_base::clear();
+        for (auto current = posted.load(); current != 0; current = posted.load())
+            posted.wait(current);
+
+        base_type::clear();
     }
 }
 
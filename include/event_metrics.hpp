@@ -0,0 +1,172 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#ifndef RPT_EVENT_METRICS
+#define RPT_EVENT_METRICS
+
+#include "detail/metrics_recorder.hpp"
+
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+namespace rpt {
+
+    /*
+        an event's metrics and the name they are exported under.
+    */
+    struct named_event_metrics {
+        std::string_view name;
+        event_metrics metrics;
+    };
+
+    /*
+    *   write metrics in the prometheus text exposition format. every counter is one metric
+    *   family with a series per event, labelled event="name", dispatch durations are a
+    *   histogram. snapshots taken with metrics compiled out are left out.
+    */
+    void write_prometheus(std::ostream&, std::span<const named_event_metrics>);
+
+    std::string to_prometheus(std::span<const named_event_metrics>);
+    std::string to_prometheus(std::string_view name, const event_metrics&);
+}
+
+namespace rpt::event_detail {
+
+    struct prometheus_writer {
+        template<typename Value>
+        void family(std::string_view name, std::string_view type, std::string_view help, Value(*get)(const event_metrics&));
+        void histogram();
+
+        void series_start(std::string_view name, std::string_view event);
+        void number(double);
+        void number(std::uint64_t);
+
+        static double seconds(std::chrono::nanoseconds);
+
+        std::ostream& out;
+        std::span<const named_event_metrics> events;
+    };
+
+    template<typename Value>
+    void prometheus_writer::family(std::string_view name, std::string_view type, std::string_view help, Value(*get)(const event_metrics&)) {
+        out << "# HELP " << name << ' ' << help << "\n# TYPE " << name << ' ' << type << '\n';
+        for (auto& e : events) {
+            if (!e.metrics.enabled)
+                continue;
+            series_start(name, e.name);
+            out << "} ";
+            number(get(e.metrics));
+            out << '\n';
+        }
+    }
+
+    inline void prometheus_writer::histogram() {
+        constexpr auto name = std::string_view{ "rpt_event_dispatch_duration_seconds" };
+        out << "# HELP " << name << " Time spent dispatching to every listener.\n# TYPE " << name << " histogram\n";
+
+        for (auto& e : events) {
+            if (!e.metrics.enabled)
+                continue;
+
+            // buckets are cumulative in the exposition format, the last one is +Inf.
+            auto total = std::uint64_t{ 0 };
+            for (auto i = std::size_t{ 0 }; i < event_metrics::latency_bucket_count; i++) {
+                total += e.metrics.dispatch_latency[i];
+                series_start(std::string{ name } + "_bucket", e.name);
+                out << ",le=\"";
+                if (i + 1 == event_metrics::latency_bucket_count)
+                    out << "+Inf";
+                else
+                    number(seconds(event_metrics::latency_bound(i)));
+                out << "\"} ";
+                number(total);
+                out << '\n';
+            }
+
+            series_start(std::string{ name } + "_sum", e.name);
+            out << "} ";
+            number(seconds(e.metrics.dispatch_time));
+            out << '\n';
+
+            series_start(std::string{ name } + "_count", e.name);
+            out << "} ";
+            number(total);
+            out << '\n';
+        }
+    }
+
+    inline void prometheus_writer::series_start(std::string_view name, std::string_view event) {
+        out << name << "{event=\"";
+        for (auto c : event) {
+            switch (c) {
+            case '\\': out << "\\\\"; break;
+            case '"': out << "\\\""; break;
+            case '\n': out << "\\n"; break;
+            default: out << c; break;
+            }
+        }
+        out << '"';
+    }
+
+    inline void prometheus_writer::number(double value) {
+        char buffer[32];
+        auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.write(buffer, end - buffer);
+    }
+
+    inline void prometheus_writer::number(std::uint64_t value) {
+        out << value;
+    }
+
+    inline double prometheus_writer::seconds(std::chrono::nanoseconds ns) {
+        return std::chrono::duration<double>(ns).count();
+    }
+}
+
+namespace rpt {
+
+    inline void write_prometheus(std::ostream& out, std::span<const named_event_metrics> events) {
+        auto writer = event_detail::prometheus_writer{ out, events };
+
+        writer.family<std::uint64_t>("rpt_event_dispatches_total", "counter", "Dispatches of the event.",
+            [](const event_metrics& m) { return m.dispatches; });
+        writer.family<std::uint64_t>("rpt_event_listeners", "gauge", "Listeners currently subscribed.",
+            [](const event_metrics& m) { return static_cast<std::uint64_t>(m.listeners); });
+        writer.family<std::uint64_t>("rpt_event_list_writes_total", "counter", "Listener lists published by subscribes and unsubscribes.",
+            [](const event_metrics& m) { return m.list_writes; });
+        writer.family<std::uint64_t>("rpt_event_write_lock_waits_total", "counter", "Writers that found the write mutex taken and waited for another writer.",
+            [](const event_metrics& m) { return m.write_lock_waits; });
+        writer.family<std::uint64_t>("rpt_event_arrays_allocated_total", "counter", "Listener arrays allocated.",
+            [](const event_metrics& m) { return m.arrays_allocated; });
+        writer.family<std::uint64_t>("rpt_event_arrays_retired_total", "counter", "Listener arrays replaced and handed to the epoch domain.",
+            [](const event_metrics& m) { return m.arrays_retired; });
+        writer.family<std::uint64_t>("rpt_event_arrays_freed_total", "counter", "Listener arrays reclaimed by the epoch domain.",
+            [](const event_metrics& m) { return m.arrays_freed; });
+        writer.family<std::uint64_t>("rpt_event_reader_waits_total", "counter", "Unsubscribes and clears that waited for running dispatches.",
+            [](const event_metrics& m) { return m.reader_waits; });
+        writer.family<double>("rpt_event_reader_wait_seconds_total", "counter", "Time spent waiting for running dispatches.",
+            [](const event_metrics& m) { return event_detail::prometheus_writer::seconds(m.reader_wait_time); });
+        writer.histogram();
+    }
+
+    inline std::string to_prometheus(std::span<const named_event_metrics> events) {
+        auto out = std::ostringstream{};
+        write_prometheus(out, events);
+        return std::move(out).str();
+    }
+
+    inline std::string to_prometheus(std::string_view name, const event_metrics& metrics) {
+        auto single = named_event_metrics{ name, metrics };
+        return to_prometheus(std::span<const named_event_metrics>{ &single, 1 });
+    }
+}
+
+#endif // RPT_EVENT_METRICS
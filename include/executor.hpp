@@ -0,0 +1,292 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#ifndef RPT_EXECUTOR
+#define RPT_EXECUTOR
+
+#include "detail/bounded_ring.hpp"
+#include "detail/waitable_atomic.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace rpt {
+
+    /*
+    *   work stealing thread pool.
+    *
+    *   every worker owns a bounded lock free ring of tasks, work submitted from a worker
+    *   goes on its own ring, work from any other thread is spread round robin. a worker with
+    *   nothing left steals from the others' rings and sleeps on a waitable_atomic once there
+    *   is nothing to steal. when every ring is full the task runs on the submitting thread.
+    *
+    *   tasks are stored in place in the ring, only callables larger than
+    *   task_type::inline_size or that may throw when moved are allocated. submitting takes
+    *   no lock.
+    *
+    *   the destructor runs everything already submitted before joining the workers.
+    */
+    class executor {
+    public:
+        /*
+            move only void() callable with a small buffer.
+        */
+        class task_type {
+        public:
+            static constexpr std::size_t inline_size = 48;
+
+            task_type() = default;
+
+            template<typename Fn, typename = std::enable_if_t<!std::is_same_v<std::remove_cvref_t<Fn>, task_type>>>
+            task_type(Fn&& fn);
+
+            task_type(task_type&&) noexcept;
+            task_type& operator=(task_type&&) noexcept;
+
+            task_type(const task_type&) = delete;
+            task_type& operator=(const task_type&) = delete;
+
+            ~task_type();
+
+            void operator()();
+
+            explicit operator bool() const;
+
+        private:
+            // moves the callable in from into to, or only destroys it when to is nullptr.
+            using relocate_type = void(*)(void* from, void* to);
+
+            template<typename Fn>
+            static constexpr bool stored_inline = sizeof(Fn) <= inline_size
+                && alignof(Fn) <= alignof(std::max_align_t)
+                && std::is_nothrow_move_constructible_v<Fn>;
+
+            void reset();
+
+            alignas(std::max_align_t) std::byte storage[inline_size];
+            void(*invoke)(void*){ nullptr };
+            relocate_type relocate{ nullptr };
+        };
+
+        static constexpr std::size_t cache_line_size = 64;
+
+        // tasks each worker's ring holds.
+        static constexpr std::size_t queue_capacity = 256;
+
+        explicit executor(std::size_t thread_count = default_thread_count());
+
+        executor(const executor&) = delete;
+        executor& operator=(const executor&) = delete;
+
+        ~executor();
+
+        /*
+            the pool used when no executor is given, never destroyed so work may still be
+            submitted while statics are torn down.
+        */
+        static executor& instance();
+
+        static std::size_t default_thread_count();
+
+        template<typename Fn>
+        void submit(Fn&&);
+
+        std::size_t size() const;
+
+        /*
+            true when called from one of this executor's workers.
+        */
+        bool running_in_this_thread() const;
+
+    private:
+        struct alignas(cache_line_size) worker {
+            event_detail::bounded_ring<task_type> tasks{ queue_capacity };
+        };
+
+        struct current_worker {
+            const executor* owner{ nullptr };
+            std::size_t index{ 0 };
+        };
+
+        void run(std::size_t index);
+        bool steal(std::size_t index, task_type&);
+
+        static thread_local current_worker current;
+
+        std::vector<std::unique_ptr<worker>> workers;
+        std::vector<std::thread> threads;
+
+        std::atomic<std::size_t> next{ 0 };
+        std::atomic<bool> stopping{ false };
+
+        // bumped on every submit, idle workers wait for it to move.
+        event_detail::waitable_atomic<std::uint64_t> signal{ 0 };
+    };
+
+    inline thread_local executor::current_worker executor::current{};
+
+    template<typename Fn, typename>
+    executor::task_type::task_type(Fn&& fn) {
+        using fn_type = std::remove_cvref_t<Fn>;
+
+        if constexpr (stored_inline<fn_type>) {
+            ::new (static_cast<void*>(storage)) fn_type(std::forward<Fn>(fn));
+            invoke = [](void* p) { (*static_cast<fn_type*>(p))(); };
+            relocate = [](void* from, void* to) {
+                auto& f = *static_cast<fn_type*>(from);
+                if (to)
+                    ::new (to) fn_type(std::move(f));
+                f.~fn_type();
+            };
+        }
+        else {
+            ::new (static_cast<void*>(storage)) fn_type*(new fn_type(std::forward<Fn>(fn)));
+            invoke = [](void* p) { (**static_cast<fn_type**>(p))(); };
+            relocate = [](void* from, void* to) {
+                auto f = *static_cast<fn_type**>(from);
+                if (to)
+                    ::new (to) fn_type*(f);
+                else
+                    delete f;
+            };
+        }
+    }
+
+    inline executor::task_type::task_type(task_type&& other) noexcept
+        : invoke{ std::exchange(other.invoke, nullptr) }
+        , relocate{ std::exchange(other.relocate, nullptr) }
+    {
+        if (relocate)
+            relocate(other.storage, storage);
+    }
+
+    inline executor::task_type& executor::task_type::operator=(task_type&& other) noexcept {
+        if (this != &other) {
+            reset();
+            invoke = std::exchange(other.invoke, nullptr);
+            relocate = std::exchange(other.relocate, nullptr);
+            if (relocate)
+                relocate(other.storage, storage);
+        }
+        return *this;
+    }
+
+    inline executor::task_type::~task_type() {
+        reset();
+    }
+
+    inline void executor::task_type::operator()() {
+        invoke(storage);
+    }
+
+    inline executor::task_type::operator bool() const {
+        return invoke != nullptr;
+    }
+
+    inline void executor::task_type::reset() {
+        if (relocate)
+            relocate(storage, nullptr);
+        invoke = nullptr;
+        relocate = nullptr;
+    }
+
+    inline executor::executor(std::size_t thread_count) {
+        thread_count = std::max<std::size_t>(thread_count, 1);
+
+        workers.reserve(thread_count);
+        for (auto i = std::size_t{ 0 }; i < thread_count; i++)
+            workers.push_back(std::make_unique<worker>());
+
+        threads.reserve(thread_count);
+        for (auto i = std::size_t{ 0 }; i < thread_count; i++)
+            threads.emplace_back([this, i]() { run(i); });
+    }
+
+    inline executor::~executor() {
+        stopping.store(true);
+        signal++;
+        signal.notify_all();
+
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    inline executor& executor::instance() {
+        static auto* pool = new executor{};
+        return *pool;
+    }
+
+    inline std::size_t executor::default_thread_count() {
+        return std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    }
+
+    template<typename Fn>
+    void executor::submit(Fn&& fn) {
+        auto index = running_in_this_thread()
+            ? current.index
+            : next.fetch_add(1, std::memory_order_relaxed) % workers.size();
+
+        auto task = task_type{ std::forward<Fn>(fn) };
+        for (auto i = std::size_t{ 0 }; i < workers.size(); i++) {
+            if (workers[(index + i) % workers.size()]->tasks.try_push(std::move(task))) {
+                signal++;
+                signal.notify_all();
+                return;
+            }
+        }
+
+        // every ring is full, the workers are behind anyway.
+        task();
+    }
+
+    inline std::size_t executor::size() const {
+        return workers.size();
+    }
+
+    inline bool executor::running_in_this_thread() const {
+        return current.owner == this;
+    }
+
+    inline void executor::run(std::size_t index) {
+        current = current_worker{ this, index };
+
+        auto task = task_type{};
+        while (true) {
+            auto seen = signal.load();
+            if (steal(index, task)) {
+                task();
+                task = task_type{};
+                continue;
+            }
+
+            if (stopping.load())
+                break;
+
+            signal.wait(seen);
+        }
+
+        current = current_worker{};
+    }
+
+    inline bool executor::steal(std::size_t index, task_type& task) {
+        // the worker's own ring first, then the others'.
+        for (auto i = std::size_t{ 0 }; i < workers.size(); i++) {
+            if (auto stolen = workers[(index + i) % workers.size()]->tasks.try_pop()) {
+                task = std::move(*stolen);
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+#endif // RPT_EXECUTOR
@@ -0,0 +1,219 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#ifndef RPT_KEYED_EVENT
+#define RPT_KEYED_EVENT
+
+#include "detail/epoch_domain.hpp"
+#include "event.hpp"
+#include "listener.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace rpt {
+
+    /*
+    *   event routed by key, every key has an event of its own so a dispatch only touches
+    *   the listeners subscribed to that key and subscribing only rebuilds that key's
+    *   listener array.
+    *
+    *   the per key events are found through an open addressed hash index that is only
+    *   ever added to. lookups take no lock, the index is replaced and the old one handed to
+    *   the epoch domain when it grows. a key keeps its event until the keyed_event is
+    *   destroyed, even once it has no listeners left.
+    */
+    template<typename Key, typename... Params>
+    class keyed_event {
+    public:
+        using key_type = Key;
+        using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+        /*
+            the per key events allocate from pool_resource::instance() unless given alloc.
+        */
+        keyed_event();
+        explicit keyed_event(allocator_type alloc);
+
+        keyed_event(const keyed_event&) = delete;
+        keyed_event& operator=(const keyed_event&) = delete;
+
+        ~keyed_event();
+
+        /*
+            dispatch to the listeners of key, does nothing for a key nobody subscribed to.
+        */
+        template<typename... Args>
+        void operator()(const Key& key, Args&&... args);
+
+        template<typename Callback>
+        listener<Callback, Params...> subscribe(const Key& key, Callback&& cb);
+
+        /*
+            the event for key, created if it does not exist yet. for use with
+            subscription_batch, next() and the other event members.
+        */
+        event<Params...>& get_event(const Key& key);
+
+        /*
+            the event for key or nullptr, never creates one.
+        */
+        event<Params...>* find(const Key& key);
+
+        std::size_t key_count() const;
+
+    private:
+        static constexpr std::size_t initial_capacity = 16;
+
+        struct entry {
+            entry(const Key& key, std::size_t hash, allocator_type alloc);
+
+            Key key;
+            std::size_t hash;
+            event<Params...> target;
+        };
+
+        struct table {
+            explicit table(std::size_t capacity);
+
+            std::size_t mask;
+            std::unique_ptr<std::atomic<entry*>[]> slots;
+        };
+
+        static std::size_t hash_of(const Key& key);
+
+        /*
+            linear probe for key, readers must hold a read section or the write mutex.
+        */
+        static entry* lookup(const table&, const Key& key, std::size_t hash);
+        static void insert(table&, entry*);
+
+        allocator_type alloc;
+
+        std::atomic<table*> index;
+
+        mutable std::mutex write_mutex;
+        std::vector<std::unique_ptr<entry>> entries;
+    };
+
+    template<typename Key, typename... Params>
+    keyed_event<Key, Params...>::entry::entry(const Key& key, std::size_t hash, allocator_type alloc)
+        : key{ key }
+        , hash{ hash }
+        , target{ alloc }
+    {}
+
+    template<typename Key, typename... Params>
+    keyed_event<Key, Params...>::table::table(std::size_t capacity)
+        : mask{ capacity - 1 }
+        , slots{ std::make_unique<std::atomic<entry*>[]>(capacity) }
+    {}
+
+    template<typename Key, typename... Params>
+    keyed_event<Key, Params...>::keyed_event()
+        : keyed_event{ allocator_type{ &pool_resource::instance() } }
+    {}
+
+    template<typename Key, typename... Params>
+    keyed_event<Key, Params...>::keyed_event(allocator_type alloc)
+        : alloc{ alloc }
+        , index{ new table{ initial_capacity } }
+    {}
+
+    template<typename Key, typename... Params>
+    keyed_event<Key, Params...>::~keyed_event() {
+        // the events wait for their own dispatches as they are destroyed.
+        entries.clear();
+        delete index.load();
+    }
+
+    template<typename Key, typename... Params>
+    template<typename... Args>
+    void keyed_event<Key, Params...>::operator()(const Key& key, Args&&... args) {
+        // entries outlive the lookup, only the index needs the read section.
+        if (auto* target = find(key))
+            (*target)(std::forward<Args>(args)...);
+    }
+
+    template<typename Key, typename... Params>
+    template<typename Callback>
+    listener<Callback, Params...> keyed_event<Key, Params...>::subscribe(const Key& key, Callback&& cb) {
+        return get_event(key).subscribe(std::forward<Callback>(cb));
+    }
+
+    template<typename Key, typename... Params>
+    event<Params...>& keyed_event<Key, Params...>::get_event(const Key& key) {
+        if (auto* target = find(key))
+            return *target;
+
+        auto hash = hash_of(key);
+        auto lock = std::lock_guard{ write_mutex };
+
+        auto* current = index.load(std::memory_order_relaxed);
+        if (auto* found = lookup(*current, key, hash))
+            return found->target;
+
+        // keep the index at most half full so probes stay short.
+        if ((entries.size() + 1) * 2 > current->mask + 1) {
+            auto* grown = new table{ (current->mask + 1) * 2 };
+            for (auto& e : entries)
+                insert(*grown, e.get());
+
+            index.store(grown, std::memory_order_release);
+            event_detail::epoch_domain::instance().retire(current);
+            current = grown;
+        }
+
+        auto& added = *entries.emplace_back(std::make_unique<entry>(key, hash, alloc));
+        insert(*current, &added);
+        return added.target;
+    }
+
+    template<typename Key, typename... Params>
+    event<Params...>* keyed_event<Key, Params...>::find(const Key& key) {
+        auto hash = hash_of(key);
+        auto guard = event_detail::epoch_domain::instance().read_lock();
+
+        auto* found = lookup(*index.load(std::memory_order_acquire), key, hash);
+        return found ? &found->target : nullptr;
+    }
+
+    template<typename Key, typename... Params>
+    std::size_t keyed_event<Key, Params...>::key_count() const {
+        auto lock = std::lock_guard{ write_mutex };
+        return entries.size();
+    }
+
+    template<typename Key, typename... Params>
+    std::size_t keyed_event<Key, Params...>::hash_of(const Key& key) {
+        return std::hash<Key>{}(key);
+    }
+
+    template<typename Key, typename... Params>
+    typename keyed_event<Key, Params...>::entry* keyed_event<Key, Params...>::lookup(const table& t, const Key& key, std::size_t hash) {
+        for (auto i = hash & t.mask;; i = (i + 1) & t.mask) {
+            auto* e = t.slots[i].load(std::memory_order_acquire);
+            if (!e)
+                return nullptr;
+            if (e->hash == hash && e->key == key)
+                return e;
+        }
+    }
+
+    template<typename Key, typename... Params>
+    void keyed_event<Key, Params...>::insert(table& t, entry* e) {
+        auto i = e->hash & t.mask;
+        while (t.slots[i].load(std::memory_order_relaxed))
+            i = (i + 1) & t.mask;
+        t.slots[i].store(e, std::memory_order_release);
+    }
+}
+
+#endif // RPT_KEYED_EVENT
@@ -5,17 +5,27 @@
 #ifndef RPT_LISTENER
 #define RPT_LISTENER
 
+#include "detail/epoch_domain.hpp"
 #include "detail/listener_base.hpp"
 
+#include <atomic>
+#include <thread>
+
 namespace rpt::event_detail {
     template<typename... Params>
     struct event_base;
+
+    template<typename... P>
+    struct get_event_base;
 }
 
 namespace rpt {
     template<typename... Params>
     class event;
 
+    template<typename... Params>
+    class subscription_batch;
+
     template<typename Callback, typename... Params>
     class listener : event_detail::listener_base<Params...> {
     public:
@@ -23,6 +33,12 @@ namespace rpt {
         template<typename CB>
         explicit listener(event<Params...>&, CB&&);
 
+        /*
+            the listener is subscribed when the batch is committed, it must not be destroyed before then.
+        */
+        template<typename CB>
+        explicit listener(subscription_batch<Params...>&, CB&&);
+
         listener() = delete;
         listener(const listener&) = delete;
         listener(listener&&) = delete;
@@ -30,46 +46,101 @@ namespace rpt {
         listener& operator= (listener&&) = delete;
 
         ~listener();
+
+        /*
+            unsubscribe without waiting, safe to call from inside a dispatch including the
+            listener's own. dispatches already running on other threads may still call it,
+            the destructor waits for those.
+        */
+        void detach();
+
     private:
+        friend subscription_batch<Params...>;
+
         using base_type = typename event_detail::listener_base<Params...>;
         using event_base_type = typename event_detail::event_base<Params...>;
-        //using event_base_type = typename event_detail::event_base<Params...>;
-        using repudiate_fn_type = void(*)(event_base_type&, base_type&);
 
-        event_base_type& event_base_ref;
-        std::atomic<repudiate_fn_type> repudiate_fn = [](event_base_type& ref, base_type& base) {
-            ref.repudiate(base);
+        enum class state_type {
+            subscribed, // the destructor unlinks and waits
+            unlinking,  // detach is unlinking, the destructor waits for it to finish
+            unlinked,   // detach has unlinked, only the wait is left for the destructor
+            released    // the event has let go, or the destructor has taken over
         };
+
+        event_base_type& event_base_ref;
+        std::atomic<state_type> state{ state_type::subscribed };
         Callback cb;
+
+        static base_type make_base();
     };
 
     template<typename... E, typename Fn>
     listener(event<E...>&, Fn&&)->listener<Fn, E...>;
 
+    template<typename... E, typename Fn>
+    listener(subscription_batch<E...>&, Fn&&)->listener<Fn, E...>;
+
     template<typename Callback, typename... Params>
     template<typename CB>
     listener<Callback, Params...>::listener(event<Params...>& event_ref, CB&& cb)
-        : base_type{
-            //TODO later make these static functions
-            [](base_type& l, Params... params) {
-                static_cast<listener<Callback, Params...>&>(l).cb(params...);
-            },
-            [](base_type& l) {
-                return static_cast<listener<Callback, Params...>&>(l).repudiate_fn.exchange(nullptr) != nullptr;
-            } }
+        : base_type{ make_base() }
         , event_base_ref{ event_detail::get_event_base<Params...>::get(event_ref) }
         , cb{ cb }
     {
                 event_base_ref.subscribe(*this);
     }
 
+    template<typename Callback, typename... Params>
+    template<typename CB>
+    listener<Callback, Params...>::listener(subscription_batch<Params...>& batch, CB&& cb)
+        : base_type{ make_base() }
+        , event_base_ref{ batch.event_base_ref }
+        , cb{ cb }
+    {
+        batch.added.push_back(this);
+    }
+
+    template<typename Callback, typename... Params>
+    typename listener<Callback, Params...>::base_type listener<Callback, Params...>::make_base() {
+        return base_type{
+            [](base_type& l, event_detail::param_t<Params>... params) {
+                static_cast<listener<Callback, Params...>&>(l).cb(params...);
+            },
+            [](base_type& l) {
+                // a listener detaching itself is left to finish, the event waits for it to be unlinked.
+                auto expected = state_type::subscribed;
+                return static_cast<listener<Callback, Params...>&>(l).state.compare_exchange_strong(expected, state_type::released);
+            } };
+    }
+
     template<typename Callback, typename... Params>
     listener<Callback, Params...>::~listener() {
-        if (auto stash = repudiate_fn.exchange(nullptr)) {
-            stash(event_base_ref, *this);
+        auto current = state.load();
+        while (true) {
+            // detach on another thread is inside unlink, which is short. it is not waited on
+            // with a notify, that would touch the listener after handing it over.
+            if (current == state_type::unlinking) {
+                std::this_thread::yield();
+                current = state.load();
+                continue;
+            }
+            if (state.compare_exchange_weak(current, state_type::released))
+                break;
         }
-        else {
 
+        if (current == state_type::subscribed)
+            event_base_ref.repudiate(*this);
+        else if (current == state_type::unlinked)
+            event_base_ref.wait_for_unlinked(*this);
+    }
+
+    template<typename Callback, typename... Params>
+    void listener<Callback, Params...>::detach() {
+        // losing the exchange means the event has let go already, or the listener is detached.
+        auto expected = state_type::subscribed;
+        if (state.compare_exchange_strong(expected, state_type::unlinking)) {
+            event_base_ref.unlink(*this);
+            state.store(state_type::unlinked);
         }
     }
 }
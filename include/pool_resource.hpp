@@ -0,0 +1,317 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#ifndef RPT_POOL_RESOURCE
+#define RPT_POOL_RESOURCE
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rpt {
+
+    struct pool_options {
+        /*
+            give every thread a shard of its own free lists (threads share shards round robin
+            once there are more threads than hardware threads), otherwise one shard for all.
+        */
+        bool per_thread_shards{ true };
+
+        /*
+            blocks taken from upstream at a time when a size class runs dry, rounded up to a
+            power of two. the first block of every slab records which shard owns it.
+        */
+        std::size_t blocks_per_slab{ 32 };
+
+        std::pmr::memory_resource* upstream{ std::pmr::new_delete_resource() };
+
+        /*
+            number of shards when per_thread_shards is set, rounded up to a power of two.
+            0 is one per hardware thread.
+        */
+        std::size_t shards{ 0 };
+    };
+
+    struct pool_stats {
+        std::size_t allocations{ 0 };
+        std::size_t deallocations{ 0 };
+
+        // allocations served from a free list without going upstream.
+        std::size_t pooled_allocations{ 0 };
+
+        // slabs and oversized blocks requested from upstream.
+        std::size_t upstream_allocations{ 0 };
+
+        std::size_t bytes_in_use{ 0 };
+        std::size_t bytes_reserved{ 0 };
+    };
+
+    /*
+    *   memory resource that recycles small blocks through per size class free lists.
+    *
+    *   requests are rounded up to a power of two from min_block_size to max_block_size and
+    *   carved out of slabs taken from upstream, larger ones go straight upstream. freed
+    *   blocks go back to the shard whose slab they came from, onto its free list when
+    *   freed by a thread of that shard and onto a lock free remote list otherwise. remote
+    *   lists are taken over by the owner once its free list runs dry, so blocks freed by
+    *   another thread, like the arrays the epoch domain reclaims, are reused instead of
+    *   making the owner take new slabs. slabs are only released when the resource is
+    *   destroyed.
+    */
+    class pool_resource : public std::pmr::memory_resource {
+    public:
+        static constexpr std::size_t cache_line_size = 64;
+        static constexpr std::size_t min_block_size = 16;
+        static constexpr std::size_t max_block_size = 4096;
+        static constexpr std::size_t class_count = std::countr_zero(max_block_size) - std::countr_zero(min_block_size) + 1;
+
+        pool_resource();
+        explicit pool_resource(const pool_options&);
+
+        pool_resource(const pool_resource&) = delete;
+        pool_resource& operator=(const pool_resource&) = delete;
+
+        ~pool_resource() override;
+
+        /*
+            the resource events allocate from by default, never destroyed so arrays retired
+            to the epoch domain can be freed while statics are torn down.
+        */
+        static pool_resource& instance();
+
+        pool_stats stats() const;
+
+        pool_options options() const;
+
+    protected:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+        void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    private:
+        struct free_block {
+            free_block* next;
+        };
+
+        /*
+            slabs are aligned to their size, the header in their first block is found by masking.
+        */
+        struct slab_header {
+            std::size_t owner;
+        };
+
+        struct slab {
+            void* ptr;
+            std::size_t bytes;
+        };
+
+        struct alignas(cache_line_size) shard {
+            std::mutex mtx;
+            std::array<free_block*, class_count> free{};
+            std::vector<slab> slabs;
+            pool_stats stats;
+
+            // blocks freed by threads of other shards, pushed without the lock.
+            alignas(cache_line_size) std::array<std::atomic<free_block*>, class_count> remote{};
+            std::atomic<std::size_t> remote_deallocations{ 0 };
+            std::atomic<std::size_t> remote_bytes{ 0 };
+        };
+
+        /*
+            size class for a request, class_count when it is too large to pool.
+        */
+        static std::size_t class_of(std::size_t bytes, std::size_t alignment);
+        static std::size_t class_size(std::size_t index);
+
+        /*
+            bytes in a slab of a size class, a power of two of at least two blocks.
+        */
+        std::size_t slab_size(std::size_t index) const;
+
+        /*
+            a small number unique to the calling thread, handed out in the order threads
+            first use any pool.
+        */
+        static std::size_t thread_index();
+
+        std::size_t local_shard_index() const;
+
+        pool_options opts;
+        std::unique_ptr<shard[]> shards;
+        std::size_t shard_count;
+
+        // oversized blocks, which bypass the shards.
+        std::atomic<std::size_t> large_allocations{ 0 };
+        std::atomic<std::size_t> large_deallocations{ 0 };
+        std::atomic<std::size_t> large_bytes{ 0 };
+    };
+
+    inline pool_resource::pool_resource()
+        : pool_resource{ pool_options{} }
+    {}
+
+    inline pool_resource::pool_resource(const pool_options& options)
+        : opts{ options }
+        , shard_count{ !options.per_thread_shards ? 1
+            : std::bit_ceil(std::clamp<std::size_t>(options.shards ? options.shards : std::thread::hardware_concurrency(), 1, 64)) }
+    {
+        opts.blocks_per_slab = std::max<std::size_t>(opts.blocks_per_slab, 2);
+        shards = std::make_unique<shard[]>(shard_count);
+    }
+
+    inline pool_resource::~pool_resource() {
+        for (auto i = std::size_t{ 0 }; i < shard_count; i++) {
+            for (auto& s : shards[i].slabs)
+                opts.upstream->deallocate(s.ptr, s.bytes, s.bytes);
+        }
+    }
+
+    inline pool_resource& pool_resource::instance() {
+        static auto* resource = new pool_resource{};
+        return *resource;
+    }
+
+    inline pool_stats pool_resource::stats() const {
+        // blocks move between shards, so a shard's own counts can wrap, only the sums are exact.
+        auto output = pool_stats{};
+        for (auto i = std::size_t{ 0 }; i < shard_count; i++) {
+            auto lock = std::lock_guard{ shards[i].mtx };
+            auto& s = shards[i].stats;
+            output.allocations += s.allocations;
+            output.deallocations += s.deallocations;
+            output.pooled_allocations += s.pooled_allocations;
+            output.upstream_allocations += s.upstream_allocations;
+            output.bytes_in_use += s.bytes_in_use;
+            output.bytes_reserved += s.bytes_reserved;
+
+            output.deallocations += shards[i].remote_deallocations.load(std::memory_order_relaxed);
+            output.bytes_in_use -= shards[i].remote_bytes.load(std::memory_order_relaxed);
+        }
+
+        auto large = large_bytes.load(std::memory_order_relaxed);
+        output.allocations += large_allocations.load(std::memory_order_relaxed);
+        output.deallocations += large_deallocations.load(std::memory_order_relaxed);
+        output.upstream_allocations += large_allocations.load(std::memory_order_relaxed);
+        output.bytes_in_use += large;
+        output.bytes_reserved += large;
+        return output;
+    }
+
+    inline pool_options pool_resource::options() const {
+        return opts;
+    }
+
+    inline void* pool_resource::do_allocate(std::size_t bytes, std::size_t alignment) {
+        auto index = class_of(bytes, alignment);
+        if (index == class_count) {
+            auto p = opts.upstream->allocate(bytes, alignment);
+            large_allocations.fetch_add(1, std::memory_order_relaxed);
+            large_bytes.fetch_add(bytes, std::memory_order_relaxed);
+            return p;
+        }
+
+        auto size = class_size(index);
+        auto owner = local_shard_index();
+        auto& s = shards[owner];
+        auto lock = std::lock_guard{ s.mtx };
+
+        s.stats.allocations++;
+        s.stats.bytes_in_use += size;
+
+        if (!s.free[index])
+            s.free[index] = s.remote[index].exchange(nullptr, std::memory_order_acquire);
+
+        if (auto block = s.free[index]) {
+            s.free[index] = block->next;
+            s.stats.pooled_allocations++;
+            return block;
+        }
+
+        // carve a new slab, the first block is its header, hand out the second and free list the rest.
+        auto slab_bytes = slab_size(index);
+        auto first = static_cast<std::byte*>(opts.upstream->allocate(slab_bytes, slab_bytes));
+        ::new (static_cast<void*>(first)) slab_header{ owner };
+        s.slabs.push_back({ first, slab_bytes });
+        s.stats.upstream_allocations++;
+        s.stats.bytes_reserved += slab_bytes;
+
+        for (auto i = slab_bytes / size - 1; i > 1; i--) {
+            auto block = ::new (static_cast<void*>(first + i * size)) free_block{ s.free[index] };
+            s.free[index] = block;
+        }
+        return first + size;
+    }
+
+    inline void pool_resource::do_deallocate(void* p, std::size_t bytes, std::size_t alignment) {
+        auto index = class_of(bytes, alignment);
+        if (index == class_count) {
+            opts.upstream->deallocate(p, bytes, alignment);
+            large_deallocations.fetch_add(1, std::memory_order_relaxed);
+            large_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+            return;
+        }
+
+        auto header = reinterpret_cast<const slab_header*>(reinterpret_cast<std::uintptr_t>(p) & ~(slab_size(index) - 1));
+        auto& s = shards[header->owner];
+
+        if (header->owner != local_shard_index()) {
+            auto& head = s.remote[index];
+            auto block = ::new (p) free_block{ head.load(std::memory_order_relaxed) };
+            while (!head.compare_exchange_weak(block->next, block, std::memory_order_release, std::memory_order_relaxed)) {}
+
+            s.remote_deallocations.fetch_add(1, std::memory_order_relaxed);
+            s.remote_bytes.fetch_add(class_size(index), std::memory_order_relaxed);
+            return;
+        }
+
+        auto lock = std::lock_guard{ s.mtx };
+
+        s.stats.deallocations++;
+        s.stats.bytes_in_use -= class_size(index);
+
+        s.free[index] = ::new (p) free_block{ s.free[index] };
+    }
+
+    inline bool pool_resource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+        return this == &other;
+    }
+
+    inline std::size_t pool_resource::class_of(std::size_t bytes, std::size_t alignment) {
+        auto size = std::bit_ceil(std::max({ bytes, alignment, min_block_size }));
+        if (size > max_block_size || alignment > cache_line_size)
+            return class_count;
+        return static_cast<std::size_t>(std::countr_zero(size) - std::countr_zero(min_block_size));
+    }
+
+    inline std::size_t pool_resource::class_size(std::size_t index) {
+        return min_block_size << index;
+    }
+
+    inline std::size_t pool_resource::slab_size(std::size_t index) const {
+        return std::bit_ceil(class_size(index) * opts.blocks_per_slab);
+    }
+
+    inline std::size_t pool_resource::local_shard_index() const {
+        if (shard_count == 1)
+            return 0;
+
+        return thread_index() & (shard_count - 1);
+    }
+
+    inline std::size_t pool_resource::thread_index() {
+        static auto next = std::atomic<std::size_t>{ 0 };
+        thread_local auto index = next.fetch_add(1, std::memory_order_relaxed);
+        return index;
+    }
+}
+
+#endif // RPT_POOL_RESOURCE
@@ -0,0 +1,158 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#ifndef RPT_QUEUED_EVENT
+#define RPT_QUEUED_EVENT
+
+#include "detail/bounded_ring.hpp"
+#include "event.hpp"
+#include "listener.hpp"
+
+#include <cstddef>
+#include <limits>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace rpt {
+
+    /*
+    *   what a queued_event does with a new value when its queue is full.
+    */
+    enum class overflow_policy {
+        block,          // wait for the consumer to make room
+        drop_newest,    // throw the new value away
+        drop_oldest,    // throw the oldest queued value away to make room
+        overwrite       // replace the newest queued value with the new one
+    };
+
+    /*
+    *   event whose dispatches are queued by any number of producer threads and delivered
+    *   on the consumer thread by dispatch_pending().
+    *
+    *   the arguments are copied into a bounded ring allocated up front, queueing never
+    *   allocates (beyond whatever copying the arguments does). only one thread may call
+    *   dispatch_pending at a time.
+    */
+    template<typename... Params>
+    class queued_event {
+    public:
+        using value_type = std::tuple<std::remove_cvref_t<Params>...>;
+
+        explicit queued_event(std::size_t capacity, overflow_policy policy = overflow_policy::block);
+
+        queued_event(const queued_event&) = delete;
+        queued_event& operator=(const queued_event&) = delete;
+
+        /*
+            queue a dispatch, returns false if the value was dropped.
+        */
+        template<typename... Args>
+        bool operator()(Args&&... args);
+
+        /*
+            dispatch up to max queued values on the calling thread, returns how many were dispatched.
+        */
+        std::size_t dispatch_pending(std::size_t max = std::numeric_limits<std::size_t>::max());
+
+        template<typename Callback>
+        listener<Callback, Params...> subscribe(Callback&&);
+
+        /*
+            the event the listeners are subscribed to, for use with subscription_batch or
+            listener's constructor. dispatching it directly skips the queue.
+        */
+        event<Params...>& get_event();
+
+        std::size_t capacity() const;
+        std::size_t pending() const;
+        overflow_policy policy() const;
+
+    private:
+        event<Params...> target;
+        event_detail::bounded_ring<value_type> ring;
+        overflow_policy full_policy;
+    };
+
+    template<typename... Params>
+    queued_event<Params...>::queued_event(std::size_t capacity, overflow_policy policy)
+        : ring{ capacity }
+        , full_policy{ policy }
+    {}
+
+    template<typename... Params>
+    template<typename... Args>
+    bool queued_event<Params...>::operator()(Args&&... args) {
+        auto value = value_type(std::forward<Args>(args)...);
+
+        switch (full_policy) {
+        case overflow_policy::block:
+            while (!ring.try_push(std::move(value))) {
+                auto seen = ring.popped();
+                if (ring.try_push(std::move(value)))
+                    break;
+                ring.wait_for_pop(seen);
+            }
+            return true;
+
+        case overflow_policy::drop_newest:
+            return ring.try_push(std::move(value));
+
+        case overflow_policy::drop_oldest:
+            while (!ring.try_push(std::move(value)))
+                ring.try_pop();
+            return true;
+
+        case overflow_policy::overwrite:
+            while (!ring.try_push(std::move(value)) && !ring.try_replace_newest(std::move(value)))
+                std::this_thread::yield();
+            return true;
+        }
+        return false;
+    }
+
+    template<typename... Params>
+    std::size_t queued_event<Params...>::dispatch_pending(std::size_t max) {
+        auto count = std::size_t{ 0 };
+        for (; count < max; count++) {
+            auto value = ring.try_pop();
+            if (!value)
+                break;
+
+            std::apply([this](auto&... params) {
+                target(params...);
+            }, *value);
+        }
+        return count;
+    }
+
+    template<typename... Params>
+    template<typename Callback>
+    listener<Callback, Params...> queued_event<Params...>::subscribe(Callback&& cb) {
+        return target.subscribe(std::forward<Callback>(cb));
+    }
+
+    template<typename... Params>
+    event<Params...>& queued_event<Params...>::get_event() {
+        return target;
+    }
+
+    template<typename... Params>
+    std::size_t queued_event<Params...>::capacity() const {
+        return ring.capacity();
+    }
+
+    template<typename... Params>
+    std::size_t queued_event<Params...>::pending() const {
+        return ring.size();
+    }
+
+    template<typename... Params>
+    overflow_policy queued_event<Params...>::policy() const {
+        return full_policy;
+    }
+}
+
+#endif // RPT_QUEUED_EVENT
@@ -0,0 +1,94 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#ifndef RPT_STATIC_EVENT
+#define RPT_STATIC_EVENT
+
+#include "detail/param_traits.hpp"
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace rpt {
+
+    template<typename Callbacks, typename... Params>
+    class static_event;
+
+    /*
+    *   event with a listener set fixed at compile time.
+    *
+    *   the callbacks are stored inline in a tuple and dispatched in order by a fold
+    *   expression, there is no listener array, snapshot or atomic to go through and the
+    *   compiler can inline every call. dispatching is as thread safe as the callbacks are.
+    *   it has the same operator() as event, so it can stand in for one whose listeners
+    *   never change.
+    */
+    template<typename... Callbacks, typename... Params>
+    class static_event<std::tuple<Callbacks...>, Params...> {
+    public:
+        static constexpr std::size_t size = sizeof...(Callbacks);
+
+        static_event() = default;
+
+        template<typename... CBs>
+            requires (sizeof...(CBs) == sizeof...(Callbacks) && sizeof...(CBs) != 0)
+        explicit constexpr static_event(CBs&&... cbs);
+
+        template<typename... Args>
+        constexpr void operator()(Args&&... args);
+
+        /*
+            the callback at index I, in the order they were given.
+        */
+        template<std::size_t I>
+        constexpr auto& get();
+
+    private:
+        template<std::size_t... I>
+        constexpr void dispatch(std::index_sequence<I...>, event_detail::param_t<Params>... params);
+
+        std::tuple<Callbacks...> callbacks;
+    };
+
+    /*
+        static_event<std::tuple<...>, Params...> holding copies of cbs.
+    */
+    template<typename... Params, typename... Callbacks>
+    constexpr static_event<std::tuple<std::decay_t<Callbacks>...>, Params...> make_static_event(Callbacks&&... cbs);
+
+    template<typename... Callbacks, typename... Params>
+    template<typename... CBs>
+        requires (sizeof...(CBs) == sizeof...(Callbacks) && sizeof...(CBs) != 0)
+    constexpr static_event<std::tuple<Callbacks...>, Params...>::static_event(CBs&&... cbs)
+        : callbacks{ std::forward<CBs>(cbs)... }
+    {}
+
+    template<typename... Callbacks, typename... Params>
+    template<typename... Args>
+    constexpr void static_event<std::tuple<Callbacks...>, Params...>::operator()(Args&&... args) {
+        dispatch(std::index_sequence_for<Callbacks...>{},
+            event_detail::forward_param<Params>(std::forward<Args>(args))...);
+    }
+
+    template<typename... Callbacks, typename... Params>
+    template<std::size_t I>
+    constexpr auto& static_event<std::tuple<Callbacks...>, Params...>::get() {
+        return std::get<I>(callbacks);
+    }
+
+    template<typename... Callbacks, typename... Params>
+    template<std::size_t... I>
+    constexpr void static_event<std::tuple<Callbacks...>, Params...>::dispatch(std::index_sequence<I...>, event_detail::param_t<Params>... params) {
+        (std::get<I>(callbacks)(params...), ...);
+    }
+
+    template<typename... Params, typename... Callbacks>
+    constexpr static_event<std::tuple<std::decay_t<Callbacks>...>, Params...> make_static_event(Callbacks&&... cbs) {
+        return static_event<std::tuple<std::decay_t<Callbacks>...>, Params...>{ std::forward<Callbacks>(cbs)... };
+    }
+}
+
+#endif // RPT_STATIC_EVENT
@@ -0,0 +1,125 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#ifndef RPT_SUBSCRIPTION_BATCH
+#define RPT_SUBSCRIPTION_BATCH
+
+#include "event.hpp"
+#include "listener.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace rpt {
+
+    /*
+    *   collects subscribes and unsubscribes for one event and applies them all with a
+    *   single new listener array and at most one wait for running dispatches.
+    *
+    *   listeners constructed from the batch become live on commit, listeners passed to
+    *   unsubscribe are removed on commit and their destructors no longer wait, both must
+    *   stay alive until then.
+    *   commit is called by the destructor. a batch is not thread safe.
+    */
+    template<typename... Params>
+    class subscription_batch {
+    public:
+        explicit subscription_batch(event<Params...>&);
+
+        subscription_batch(const subscription_batch&) = delete;
+        subscription_batch& operator=(const subscription_batch&) = delete;
+
+        ~subscription_batch();
+
+        template<typename Callback>
+        listener<Callback, Params...> subscribe(Callback&&);
+
+        template<typename Callback>
+        void unsubscribe(listener<Callback, Params...>&);
+
+        template<typename It>
+        void unsubscribe(It first, It last);
+
+        /*
+            apply everything collected so far, returns once none of the unsubscribed
+            listeners can be called.
+        */
+        void commit();
+
+        std::size_t pending() const;
+
+    private:
+        template<typename, typename...>
+        friend class listener;
+
+        using event_base_type = event_detail::event_base<Params...>;
+        using listener_base_type = event_detail::listener_base<Params...>;
+
+        event_base_type& event_base_ref;
+        std::vector<listener_base_type*> added;
+        std::vector<listener_base_type*> removed;
+    };
+
+    template<typename... E>
+    subscription_batch(event<E...>&)->subscription_batch<E...>;
+
+    template<typename... Params>
+    subscription_batch<Params...>::subscription_batch(event<Params...>& event_ref)
+        : event_base_ref{ event_detail::get_event_base<Params...>::get(event_ref) }
+    {}
+
+    template<typename... Params>
+    subscription_batch<Params...>::~subscription_batch() {
+        commit();
+    }
+
+    template<typename... Params>
+    template<typename Callback>
+    listener<Callback, Params...> subscription_batch<Params...>::subscribe(Callback&& cb) {
+        return listener<Callback, Params...>(*this, std::move(cb));
+    }
+
+    template<typename... Params>
+    template<typename Callback>
+    void subscription_batch<Params...>::unsubscribe(listener<Callback, Params...>& l) {
+        auto& base = static_cast<listener_base_type&>(l);
+        if (base.detatch())
+            removed.push_back(&base);
+    }
+
+    template<typename... Params>
+    template<typename It>
+    void subscription_batch<Params...>::unsubscribe(It first, It last) {
+        std::for_each(first, last, [this](auto& l) { unsubscribe(l); });
+    }
+
+    template<typename... Params>
+    void subscription_batch<Params...>::commit() {
+        if (added.empty() && removed.empty())
+            return;
+
+        // a listener can be added and removed in the same batch, it never needs to be published.
+        std::sort(removed.begin(), removed.end());
+        auto unpublished = std::partition(added.begin(), added.end(), [this](auto l) {
+            return !std::binary_search(removed.begin(), removed.end(), l);
+        });
+        std::for_each(unpublished, added.end(), [this](auto l) {
+            removed.erase(std::lower_bound(removed.begin(), removed.end(), l));
+        });
+        added.erase(unpublished, added.end());
+
+        if (!added.empty() || !removed.empty())
+            event_base_ref.update(added, removed);
+
+        added.clear();
+        removed.clear();
+    }
+
+    template<typename... Params>
+    std::size_t subscription_batch<Params...>::pending() const {
+        return added.size() + removed.size();
+    }
+}
+
+#endif // RPT_SUBSCRIPTION_BATCH
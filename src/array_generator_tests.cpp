@@ -5,7 +5,9 @@
 #include "pch.h"
 
 #include "detail/array_generator.hpp"
+#include "detail/listener_base.hpp"
 
+#include <algorithm>
 #include <array>
 #include <memory_resource>
 #include <numeric>
@@ -13,6 +15,8 @@
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
 using rpt::event_detail::array_generator;
+using rpt::event_detail::dispatch_entry;
+using rpt::event_detail::listener_base;
 
 namespace rpt::event_detail_tests {
 
@@ -24,7 +28,10 @@ namespace rpt::event_detail_tests {
 		TEST_METHOD(copy_push_back_array);
 
 		TEST_METHOD(copy_remove_array);
+		TEST_METHOD(copy_update_array);
+		TEST_METHOD(tombstone_compact_array);
 		TEST_METHOD(big_array);
+		TEST_METHOD(dispatch_entries);
 	};
 
 	void array_generator_tests::construct()
@@ -50,8 +57,8 @@ namespace rpt::event_detail_tests {
 
 		auto array = generator.make_array(test);
 
-		Assert::AreEqual(generator.get_size(array), 1ull);
-		Assert::AreEqual(generator.get_generation(array), 1ull);
+		Assert::AreEqual<std::size_t>(generator.get_size(array), 1);
+		Assert::AreEqual<std::uintptr_t>(generator.get_generation(array), 1);
 		Assert::AreEqual(generator.get_data(array)[0], &test);
 	}
 
@@ -65,12 +72,12 @@ namespace rpt::event_detail_tests {
 		auto array1 = generator.make_array(test1);
 		auto array2 = generator.copy_push_back(array1, test2);
 
-		Assert::AreEqual(1ull, generator.get_size(array1));
-		Assert::AreEqual(1ull, generator.get_generation(array1));
+		Assert::AreEqual<std::size_t>(1, generator.get_size(array1));
+		Assert::AreEqual<std::uintptr_t>(1, generator.get_generation(array1));
 		Assert::AreEqual(&test1, generator.get_data(array1)[0]);
 
-		Assert::AreEqual(2ull, generator.get_size(array2));
-		Assert::AreEqual(2ull, generator.get_generation(array2));
+		Assert::AreEqual<std::size_t>(2, generator.get_size(array2));
+		Assert::AreEqual<std::uintptr_t>(2, generator.get_generation(array2));
 		Assert::AreEqual(&test1, generator.get_data(array2)[0]);
 		Assert::AreEqual(&test2, generator.get_data(array2)[1]);
 	}
@@ -87,20 +94,82 @@ namespace rpt::event_detail_tests {
 		auto array3 = generator.copy_remove(array2, test1);
 		auto array4 = generator.copy_remove(array2, test2);
 
-		Assert::AreEqual(2ull, generator.get_size(array2));
-		Assert::AreEqual(2ull, generator.get_generation(array2));
+		Assert::AreEqual<std::size_t>(2, generator.get_size(array2));
+		Assert::AreEqual<std::uintptr_t>(2, generator.get_generation(array2));
 		Assert::AreEqual(&test1, generator.get_data(array2)[0]);
 		Assert::AreEqual(&test2, generator.get_data(array2)[1]);
 
-		Assert::AreEqual(1ull, generator.get_size(array3));
-		Assert::AreEqual(3ull, generator.get_generation(array3));
+		Assert::AreEqual<std::size_t>(1, generator.get_size(array3));
+		Assert::AreEqual<std::uintptr_t>(3, generator.get_generation(array3));
 		Assert::AreEqual(&test2, generator.get_data(array3)[0]);
 
-		Assert::AreEqual(1ull, generator.get_size(array4));
-		Assert::AreEqual(3ull, generator.get_generation(array4));
+		Assert::AreEqual<std::size_t>(1, generator.get_size(array4));
+		Assert::AreEqual<std::uintptr_t>(3, generator.get_generation(array4));
 		Assert::AreEqual(&test1, generator.get_data(array4)[0]);
 	}
 
+	void array_generator_tests::copy_update_array()
+	{
+		auto generator = array_generator<int*>{};
+
+		std::array<int, 5> tests = { 1,2,3,5,7 };
+
+		auto array1 = generator.make_array(tests[0]);
+		array1 = generator.copy_push_back(array1, tests[1]);
+		array1 = generator.copy_push_back(array1, tests[2]);
+
+		auto added = std::array<int*, 2>{ &tests[3], &tests[4] };
+		auto removed = std::array<int*, 2>{ &tests[0], &tests[2] };
+		std::sort(removed.begin(), removed.end());
+
+		auto array2 = generator.copy_update(array1, added, removed);
+
+		Assert::AreEqual<std::size_t>(3, generator.get_size(array2));
+		Assert::AreEqual<std::uintptr_t>(4, generator.get_generation(array2));
+		Assert::AreEqual(&tests[1], generator.get_data(array2)[0]);
+		Assert::AreEqual(&tests[3], generator.get_data(array2)[1]);
+		Assert::AreEqual(&tests[4], generator.get_data(array2)[2]);
+
+		auto missing = std::array<int*, 1>{ &tests[0] };
+		auto array3 = generator.copy_update(array2, std::array<int*, 0>{}, missing);
+
+		Assert::AreEqual<std::size_t>(3, generator.get_size(array3));
+	}
+
+	void array_generator_tests::tombstone_compact_array()
+	{
+		auto generator = array_generator<int*>{};
+
+		std::array<int, 4> tests = { 1,2,3,5 };
+
+		auto array1 = generator.make_array(tests[0]);
+		array1 = generator.copy_push_back(array1, tests[1]);
+		array1 = generator.copy_push_back(array1, tests[2]);
+
+		generator.tombstone(generator.get_data(array1)[1]);
+
+		Assert::IsNull(generator.load_entry(generator.get_data(array1)[1]));
+		Assert::AreEqual(&tests[2], generator.load_entry(generator.get_data(array1)[2]));
+
+		// tombstones keep their slot until the array is compacted.
+		auto array2 = generator.copy_push_back(array1, tests[3]);
+
+		Assert::AreEqual<std::size_t>(4, generator.get_size(array2));
+		Assert::IsNull(generator.get_data(array2)[1]);
+
+		auto array3 = generator.copy_compact(array2);
+
+		Assert::AreEqual<std::size_t>(3, generator.get_size(array3));
+		Assert::AreEqual<std::uintptr_t>(5, generator.get_generation(array3));
+		Assert::AreEqual(&tests[0], generator.get_data(array3)[0]);
+		Assert::AreEqual(&tests[2], generator.get_data(array3)[1]);
+		Assert::AreEqual(&tests[3], generator.get_data(array3)[2]);
+
+		auto array4 = generator.copy_update(array2, std::array<int*, 0>{}, std::array<int*, 0>{});
+
+		Assert::AreEqual<std::size_t>(3, generator.get_size(array4));
+	}
+
 	void array_generator_tests::big_array()
 	{
 		auto generator = array_generator<int*>{};
@@ -114,7 +183,41 @@ namespace rpt::event_detail_tests {
 											return generator.copy_push_back(acc, test);
 										 });
 
-		Assert::AreEqual(10ull, generator.get_size(big_array));
+		Assert::AreEqual<std::size_t>(10, generator.get_size(big_array));
 	}
 
-}
\ No newline at end of file
+
+	void array_generator_tests::dispatch_entries()
+	{
+		using listener_type = listener_base<int*>;
+		auto generator = array_generator<dispatch_entry<int*>>{};
+
+		auto tests = std::array<listener_type, 3>{
+			listener_type{ [](auto&, int* count) { (*count) += 1; } },
+			listener_type{ [](auto&, int* count) { (*count) += 10; } },
+			listener_type{ [](auto&, int* count) { (*count) += 100; } } };
+
+		auto array = generator.make_array(tests[0]);
+		array = generator.copy_push_back(array, tests[1]);
+		array = generator.copy_push_back(array, tests[2]);
+
+		// the callback is stored next to the listener it belongs to.
+		for (auto i = 0; i < 3; i++) {
+			Assert::IsTrue(generator.get_data(array)[i].listener == &tests[i]);
+			Assert::IsTrue(generator.get_data(array)[i].callback == tests[i]._callback);
+		}
+
+		generator.tombstone(generator.get_data(array)[1]);
+		Assert::IsNull(generator.load_entry(generator.get_data(array)[1]));
+
+		auto compact = generator.copy_compact(array);
+
+		auto count = 0;
+		std::for_each_n(generator.get_data(compact), generator.get_size(compact), [&count](auto& entry) {
+			entry.callback(*entry.listener, &count);
+		});
+
+		Assert::AreEqual<std::size_t>(2, generator.get_size(compact));
+		Assert::AreEqual(101, count);
+	}
+}
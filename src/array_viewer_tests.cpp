@@ -19,6 +19,7 @@ namespace rpt::event_detail_tests {
 	TEST_CLASS(array_viewer_tests) {
 	public:
 		TEST_METHOD(construct);
+		TEST_METHOD(skip_tombstones);
 		TEST_METHOD(move_construct_TODO) {}
 	};
 
@@ -48,4 +49,22 @@ namespace rpt::event_detail_tests {
 		Assert::AreEqual(29, *std::next(view.begin(), 5));
 	}
 
-}
\ No newline at end of file
+	void array_viewer_tests::skip_tombstones() {
+		auto arr = std::array{ 1,2,3,5,7 };
+
+		auto array = make_array<int>(arr);
+		auto generator = event_detail::array_generator<int*>{};
+		generator.tombstone(generator.get_data(array)[0]);
+		generator.tombstone(generator.get_data(array)[2]);
+		generator.tombstone(generator.get_data(array)[4]);
+
+		auto ptr = std::shared_ptr<decltype(array)::element_type[]>{ array, array.get() + 2 };
+		auto view = array_viewer<int>(ptr, arr.size());
+
+		auto expected = std::array{ 2,5 };
+
+		Assert::AreEqual<std::size_t>(2, view.size());
+		Assert::IsTrue(std::equal(expected.begin(), expected.end(), view.begin(), view.end()));
+	}
+
+}
@@ -0,0 +1,241 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#include "pch.h"
+
+#include "broadcast_ring.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace rpt::broadcast_ring_tests {
+
+	/*
+		runs its hook while it is moved into a slot, standing in for a producer that lags.
+	*/
+	struct lagging {
+		lagging(int value, std::function<void()> hook)
+			: value{ value }
+			, hook{ std::move(hook) }
+		{}
+
+		lagging(lagging&& other)
+			: value{ other.value }
+		{
+			if (auto h = std::exchange(other.hook, nullptr))
+				h();
+		}
+
+		int value;
+		std::function<void()> hook;
+	};
+
+	TEST_CLASS(broadcast_ring_tests) {
+	public:
+		TEST_METHOD(construct);
+
+		TEST_METHOD(every_consumer_sees_everything);
+
+		TEST_METHOD(consumer_threads);
+
+		TEST_METHOD(many_producers);
+
+		TEST_METHOD(slow_consumer_gates);
+
+		TEST_METHOD(unsubscribe_while_publishing);
+
+		TEST_METHOD(lagging_producer);
+	};
+
+	void broadcast_ring_tests::construct() {
+		auto test = broadcast_ring<int>{ 6 };
+
+		Assert::AreEqual<std::size_t>(8, test.capacity());
+		Assert::AreEqual<std::int64_t>(-1, test.claimed());
+	}
+
+	void broadcast_ring_tests::every_consumer_sees_everything() {
+		constexpr auto count = 10000;
+
+		auto test = broadcast_ring<int, std::string>{ 8 };
+
+		auto seen_a = std::vector<int>{};
+		auto seen_b = std::vector<int>{};
+		{
+			auto a = test.subscribe([&seen_a](int i, const std::string& s) { seen_a.push_back(i + static_cast<int>(s.size())); });
+			auto b = test.subscribe([&seen_b](int i, const std::string&) { seen_b.push_back(i); });
+
+			for (auto i = 0; i < count; i++)
+				test(i, "");
+
+			while (a.cursor() != count - 1 || b.cursor() != count - 1)
+				std::this_thread::yield();
+		}
+
+		Assert::AreEqual<std::size_t>(count, seen_a.size());
+		Assert::AreEqual<std::size_t>(count, seen_b.size());
+		for (auto i = 0; i < count; i++) {
+			Assert::AreEqual(i, seen_a[i]);
+			Assert::AreEqual(i, seen_b[i]);
+		}
+	}
+
+	void broadcast_ring_tests::consumer_threads() {
+		auto test = broadcast_ring<>{ 4 };
+
+		auto id_a = std::atomic<std::thread::id>{};
+		auto id_b = std::atomic<std::thread::id>{};
+		{
+			auto a = test.subscribe([&id_a]() { id_a = std::this_thread::get_id(); });
+			auto b = test.subscribe([&id_b]() { id_b = std::this_thread::get_id(); });
+
+			test();
+
+			while (a.cursor() != 0 || b.cursor() != 0)
+				std::this_thread::yield();
+		}
+
+		// no consumer runs on the producer or on another consumer's thread.
+		Assert::IsTrue(id_a.load() != std::this_thread::get_id());
+		Assert::IsTrue(id_b.load() != std::this_thread::get_id());
+		Assert::IsTrue(id_a.load() != id_b.load());
+	}
+
+	void broadcast_ring_tests::many_producers() {
+		constexpr auto producer_count = 4;
+		constexpr auto per_producer = 5000;
+
+		auto test = broadcast_ring<int, int>{ 16 };
+
+		auto last = std::vector<int>(producer_count, -1);
+		auto out_of_order = 0;
+		auto total = 0;
+		{
+			auto c = test.subscribe([&](int producer, int value) {
+				if (value != last[producer] + 1)
+					out_of_order++;
+				last[producer] = value;
+				total++;
+			});
+
+			auto producers = std::vector<std::thread>{};
+			for (auto p = 0; p < producer_count; p++) {
+				producers.emplace_back([&test, p]() {
+					for (auto i = 0; i < per_producer; i++)
+						test(p, i);
+				});
+			}
+			for (auto& producer : producers)
+				producer.join();
+
+			while (c.cursor() != test.claimed())
+				std::this_thread::yield();
+		}
+
+		Assert::AreEqual(0, out_of_order);
+		Assert::AreEqual(producer_count * per_producer, total);
+	}
+
+	void broadcast_ring_tests::slow_consumer_gates() {
+		auto test = broadcast_ring<int>{ 2 };
+
+		auto release = std::atomic<bool>{ false };
+		auto c = test.subscribe([&release](int) {
+			while (!release.load())
+				std::this_thread::yield();
+		});
+
+		// the consumer is stuck on the first value, the third needs its slot.
+		test(0);
+		test(1);
+
+		auto published = std::atomic<bool>{ false };
+		auto producer = std::thread([&]() {
+			test(2);
+			published = true;
+		});
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		Assert::IsFalse(published.load());
+
+		release = true;
+		producer.join();
+
+		while (c.cursor() != 2)
+			std::this_thread::yield();
+	}
+
+	void broadcast_ring_tests::unsubscribe_while_publishing() {
+		auto test = broadcast_ring<int>{ 4 };
+
+		auto stop = std::atomic<bool>{ false };
+		auto producer = std::thread([&]() {
+			for (auto i = 0; !stop.load(); i++)
+				test(i);
+		});
+
+		for (auto round = 0; round < 50; round++) {
+			auto seen = std::atomic<int>{ 0 };
+			auto c = test.subscribe([&seen](int) { seen++; });
+			while (seen.load() == 0)
+				std::this_thread::yield();
+		}
+
+		stop = true;
+		producer.join();
+	}
+
+	void broadcast_ring_tests::lagging_producer() {
+		auto test = broadcast_ring<lagging>{ 4 };
+		auto capacity = static_cast<int>(test.capacity());
+
+		auto fast = std::vector<std::thread>{};
+		auto fast_done = std::atomic<int>{ 0 };
+		auto done_while_lagging = -1;
+		auto published_while_lagging = std::int64_t{ 0 };
+
+		auto c = std::optional<broadcast_ring<lagging>::consumer>{};
+		auto seen = std::vector<int>{};
+
+		// no consumers yet, the other producers claim a lap and more while the first is writing.
+		auto slow = std::thread([&]() {
+			test(lagging{ -1, [&]() {
+				for (auto i = 0; i <= capacity; i++) {
+					fast.emplace_back([&test, &fast_done, i]() {
+						test(lagging{ i, nullptr });
+						fast_done++;
+					});
+				}
+				while (test.claimed() != capacity + 1)
+					std::this_thread::yield();
+
+				done_while_lagging = fast_done.load();
+				published_while_lagging = test.published();
+				c.emplace(test.subscribe([&seen](const lagging& l) { seen.push_back(l.value); }));
+			} });
+		});
+		slow.join();
+		for (auto& thread : fast)
+			thread.join();
+
+		while (c->cursor() != test.claimed())
+			std::this_thread::yield();
+		c.reset();
+
+		// nobody published past the lagging slot, and the consumer saw it and everything after.
+		Assert::AreEqual(0, done_while_lagging);
+		Assert::AreEqual<std::int64_t>(-1, published_while_lagging);
+		Assert::AreEqual<std::size_t>(capacity + 2, seen.size());
+		Assert::AreEqual(-1, seen[0]);
+		Assert::AreEqual(test.claimed(), test.published());
+	}
+}
@@ -0,0 +1,136 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#include "pch.h"
+
+#include "conflating_event.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace rpt::conflating_event_tests {
+
+	TEST_CLASS(conflating_event_tests) {
+	public:
+		TEST_METHOD(construct);
+
+		TEST_METHOD(latest_only);
+
+		TEST_METHOD(notify_once_per_pending);
+
+		TEST_METHOD(wait);
+
+		TEST_METHOD(burst);
+	};
+
+	void conflating_event_tests::construct() {
+		auto test = conflating_event<int, std::string>{};
+
+		Assert::IsFalse(test.pending());
+		Assert::IsFalse(test.dispatch_pending());
+	}
+
+	void conflating_event_tests::latest_only() {
+		auto test = conflating_event<int, std::string>{};
+
+		auto seen = std::vector<std::string>{};
+		auto l = test.subscribe([&seen](int i, const std::string& s) {
+			seen.push_back(std::to_string(i) + s);
+		});
+
+		test(1, "a");
+		test(2, "b");
+		test(3, "c");
+
+		// nothing runs on the producer.
+		Assert::IsTrue(seen.empty());
+		Assert::IsTrue(test.pending());
+
+		Assert::IsTrue(test.dispatch_pending());
+		Assert::IsFalse(test.dispatch_pending());
+
+		test(4, "d");
+
+		Assert::IsTrue(test.dispatch_pending());
+		Assert::IsTrue(seen == std::vector<std::string>{ "3c", "4d" });
+	}
+
+	void conflating_event_tests::notify_once_per_pending() {
+		auto test = conflating_event<int>{};
+
+		Assert::IsTrue(test(1));
+		Assert::IsFalse(test(2));
+		Assert::IsFalse(test(3));
+
+		test.dispatch_pending();
+
+		Assert::IsTrue(test(4));
+	}
+
+	void conflating_event_tests::wait() {
+		auto test = conflating_event<int>{};
+		auto released = std::atomic<bool>{ false };
+
+		// the sleep only makes it likely the wait blocks, the check is on ordering.
+		auto producer = std::thread([&]() {
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+			released = true;
+			test(1);
+		});
+
+		test.wait();
+
+		// the wait can only have returned once the update it was waiting for was published.
+		auto seen_released = released.load();
+
+		producer.join();
+
+		Assert::IsTrue(test.pending());
+		Assert::IsTrue(seen_released);
+	}
+
+	void conflating_event_tests::burst() {
+		constexpr auto producer_count = 2;
+		constexpr auto per_producer = 100000;
+
+		auto test = conflating_event<int, int>{};
+
+		auto dispatches = 0;
+		auto torn = 0;
+		auto last = std::vector<int>(producer_count, 0);
+		auto l = test.subscribe([&](int producer, int value) {
+			dispatches++;
+			if (value <= last[producer])
+				torn++;
+			last[producer] = value;
+		});
+
+		auto finished = std::atomic<int>{ 0 };
+		auto producers = std::vector<std::thread>{};
+		for (auto p = 0; p < producer_count; p++) {
+			producers.emplace_back([&test, &finished, p]() {
+				for (auto i = 1; i <= per_producer; i++)
+					test(p, i);
+				finished++;
+			});
+		}
+
+		while (finished.load() != producer_count)
+			test.dispatch_pending();
+
+		for (auto& producer : producers)
+			producer.join();
+		test.dispatch_pending();
+
+		// a producer's values only ever go forwards and the final one is always delivered.
+		Assert::AreEqual(0, torn);
+		Assert::IsTrue(last[0] == per_producer || last[1] == per_producer);
+		Assert::IsTrue(dispatches <= producer_count * per_producer);
+	}
+}
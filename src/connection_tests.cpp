@@ -0,0 +1,378 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#include "pch.h"
+
+#include "connection.hpp"
+#include "event.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace rpt::connection_tests {
+
+	TEST_CLASS(connection_tests) {
+	public:
+		TEST_METHOD(construct);
+
+		TEST_METHOD(connect_disconnect);
+
+		TEST_METHOD(unscoped);
+
+		TEST_METHOD(scoped);
+
+		TEST_METHOD(vector_of_connections);
+
+		TEST_METHOD(event_destroyed_first);
+
+		TEST_METHOD(disconnect_in_dispatch);
+
+		TEST_METHOD(disconnect_while_dispatching);
+
+		TEST_METHOD(disconnect_async);
+
+		TEST_METHOD(disconnect_async_in_dispatch);
+
+		TEST_METHOD(disconnect_async_while_dispatching);
+
+		TEST_METHOD(disconnect_async_no_late_calls);
+
+		TEST_METHOD(subscribe_once);
+
+		TEST_METHOD(subscribe_once_cancelled);
+
+		TEST_METHOD(subscribe_once_rearm);
+
+		TEST_METHOD(subscribe_once_concurrent);
+	};
+
+	void connection_tests::construct() {
+		auto test = connection{};
+		Assert::IsFalse(test.connected());
+		test.disconnect();
+
+		auto scoped = scoped_connection{};
+		Assert::IsFalse(static_cast<bool>(scoped));
+	}
+
+	void connection_tests::connect_disconnect() {
+		auto e = event<int, const std::string&>{};
+
+		auto total = 0;
+		auto test = e.connect([&total](int i, const std::string& s) { total += i + static_cast<int>(s.size()); });
+
+		Assert::IsTrue(test.connected());
+		e(1, "ab");
+		Assert::AreEqual(3, total);
+
+		test.disconnect();
+		Assert::IsFalse(test.connected());
+		e(1, "ab");
+		Assert::AreEqual(3, total);
+
+		// a second disconnect does nothing.
+		test.disconnect();
+	}
+
+	void connection_tests::unscoped() {
+		auto e = event<int>{};
+
+		auto total = 0;
+		{
+			auto test = e.connect([&total](int i) { total += i; });
+		}
+
+		// dropping the handle does not unsubscribe.
+		e(2);
+		Assert::AreEqual(2, total);
+	}
+
+	void connection_tests::scoped() {
+		auto e = event<int>{};
+
+		auto total = 0;
+		{
+			auto test = scoped_connection{ e.connect([&total](int i) { total += i; }) };
+			e(2);
+		}
+		e(2);
+		Assert::AreEqual(2, total);
+
+		auto kept = connection{};
+		{
+			auto test = scoped_connection{ e.connect([&total](int i) { total += i; }) };
+			kept = test.release();
+		}
+		e(3);
+		Assert::AreEqual(5, total);
+		Assert::IsTrue(kept.connected());
+
+		// assigning over a scoped connection ends the old subscription.
+		auto first = scoped_connection{ std::move(kept) };
+		first = scoped_connection{ e.connect([&total](int i) { total += 10 * i; }) };
+		e(1);
+		Assert::AreEqual(15, total);
+	}
+
+	void connection_tests::vector_of_connections() {
+		constexpr auto count = 1000;
+
+		auto e = event<int>{};
+		auto total = 0;
+
+		auto connections = std::vector<scoped_connection>{};
+		for (auto i = 0; i < count; i++)
+			connections.emplace_back(e.connect([&total](int x) { total += x; }));
+
+		e(1);
+		Assert::AreEqual(count, total);
+
+		connections.erase(connections.begin(), connections.begin() + count / 2);
+		e(1);
+		Assert::AreEqual(count + count / 2, total);
+
+		connections.clear();
+		e(1);
+		Assert::AreEqual(count + count / 2, total);
+	}
+
+	void connection_tests::event_destroyed_first() {
+		auto test = connection{};
+		{
+			auto e = event<int>{};
+			test = e.connect([](int) {});
+			Assert::IsTrue(test.connected());
+		}
+
+		Assert::IsFalse(test.connected());
+		test.disconnect();
+	}
+
+	void connection_tests::disconnect_in_dispatch() {
+		auto e = event<int>{};
+
+		auto calls = 0;
+		auto test = connection{};
+		test = e.connect([&calls, &test](int) {
+			calls++;
+			test.disconnect();
+		});
+
+		e(1);
+		e(1);
+		Assert::AreEqual(1, calls);
+	}
+
+	void connection_tests::disconnect_while_dispatching() {
+		auto e = event<int>{};
+
+		auto stop = std::atomic<bool>{ false };
+		auto dispatcher = std::thread([&]() {
+			while (!stop.load())
+				e(1);
+		});
+
+		for (auto round = 0; round < 200; round++) {
+			auto value = std::make_shared<int>(0);
+			auto test = scoped_connection{ e.connect([value](int i) { *value += i; }) };
+		}
+
+		stop = true;
+		dispatcher.join();
+	}
+
+	void connection_tests::disconnect_async() {
+		auto e = event<int>{};
+
+		auto total = 0;
+		auto test = e.connect([&total](int i) { total += i; });
+		e(1);
+
+		auto done = test.disconnect_async();
+		Assert::IsFalse(test.connected());
+		e(1);
+		Assert::AreEqual(1, total);
+
+		done.wait();
+		Assert::IsTrue(done.done());
+
+		// nothing left to wait for.
+		Assert::IsTrue(test.disconnect_async().done());
+
+		auto scoped = scoped_connection{ e.connect([&total](int i) { total += i; }) };
+		scoped.disconnect_async().wait();
+		e(1);
+		Assert::AreEqual(1, total);
+	}
+
+	void connection_tests::disconnect_async_in_dispatch() {
+		auto e = event<int>{};
+
+		auto calls = 0;
+		auto done = completion{};
+		auto test = connection{};
+		test = e.connect([&](int) {
+			calls++;
+			done = test.disconnect_async();
+		});
+
+		e(1);
+		e(1);
+		Assert::AreEqual(1, calls);
+		done.wait();
+	}
+
+	void connection_tests::disconnect_async_while_dispatching() {
+		auto e = event<int>{};
+
+		auto entered = std::atomic<bool>{ false };
+		auto release = std::atomic<bool>{ false };
+		auto calls = std::make_shared<std::atomic<int>>(0);
+
+		auto test = e.connect([&, calls](int) {
+			calls->fetch_add(1);
+			entered = true;
+			while (!release.load())
+				std::this_thread::yield();
+		});
+
+		auto dispatcher = std::thread([&]() { e(1); });
+		while (!entered.load())
+			std::this_thread::yield();
+
+		// returns straight away although the callback is still running.
+		auto done = test.disconnect_async();
+		Assert::IsFalse(test.connected());
+		Assert::IsFalse(done.done());
+
+		e(1);
+		Assert::AreEqual(1, calls->load());
+
+		release = true;
+		done.wait();
+		dispatcher.join();
+		Assert::AreEqual(1, calls->load());
+	}
+
+	void connection_tests::disconnect_async_no_late_calls() {
+		auto e = event<int>{};
+
+		auto completed = std::atomic<bool>{ false };
+		auto late = std::atomic<bool>{ false };
+		auto stop = std::atomic<bool>{ false };
+		auto calls = std::atomic<int>{ 0 };
+
+		auto test = e.connect([&](int) {
+			if (completed.load())
+				late = true;
+			calls++;
+		});
+
+		auto dispatcher = std::thread([&]() {
+			while (!stop.load())
+				e(1);
+		});
+		while (calls.load() == 0)
+			std::this_thread::yield();
+
+		// no call may start once the completion is done.
+		test.disconnect_async().wait();
+		completed = true;
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		stop = true;
+		dispatcher.join();
+
+		Assert::IsFalse(late.load());
+	}
+
+	void connection_tests::subscribe_once() {
+		auto e = event<int>{};
+
+		auto total = 0;
+		auto test = e.subscribe_once([&total](int i) { total += i; });
+		Assert::IsTrue(test.connected());
+
+		e(2);
+		Assert::IsFalse(test.connected());
+		e(3);
+		Assert::AreEqual(2, total);
+
+		// the handle does not have to be kept.
+		for (auto i = 0; i < 100; i++)
+			e.subscribe_once([&total](int i) { total += i; });
+
+		e(1);
+		e(1);
+		Assert::AreEqual(102, total);
+		Assert::IsTrue(event_detail::get_event_base<int>::get(e).empty());
+	}
+
+	void connection_tests::subscribe_once_cancelled() {
+		auto e = event<int>{};
+
+		auto total = 0;
+		auto test = e.subscribe_once([&total](int i) { total += i; });
+		test.disconnect();
+
+		e(2);
+		Assert::AreEqual(0, total);
+
+		// left pending until the event goes away.
+		auto kept = connection{};
+		{
+			auto other = event<int>{};
+			kept = other.subscribe_once([&total](int i) { total += i; });
+		}
+		Assert::IsFalse(kept.connected());
+		Assert::AreEqual(0, total);
+	}
+
+	void connection_tests::subscribe_once_rearm() {
+		auto e = event<int>{};
+
+		auto calls = 0;
+		auto handler = std::function<void(int)>{};
+		handler = [&](int) {
+			calls++;
+			if (calls < 3)
+				e.subscribe_once(handler);
+		};
+		e.subscribe_once(handler);
+
+		for (auto i = 0; i < 5; i++)
+			e(1);
+
+		Assert::AreEqual(3, calls);
+		Assert::IsTrue(event_detail::get_event_base<int>::get(e).empty());
+	}
+
+	void connection_tests::subscribe_once_concurrent() {
+		constexpr auto thread_count = 4;
+		constexpr auto rounds = 200;
+
+		auto e = event<int>{};
+
+		for (auto round = 0; round < rounds; round++) {
+			auto calls = std::make_shared<std::atomic<int>>(0);
+			e.subscribe_once([calls](int) { calls->fetch_add(1); });
+
+			auto threads = std::vector<std::thread>{};
+			for (auto i = 0; i < thread_count; i++)
+				threads.emplace_back([&e]() { e(1); });
+			for (auto& thread : threads)
+				thread.join();
+
+			Assert::AreEqual(1, calls->load());
+		}
+	}
+}
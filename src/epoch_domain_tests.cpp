@@ -0,0 +1,136 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#include "pch.h"
+
+#include "detail/epoch_domain.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace rpt::event_detail_tests {
+
+	using rpt::event_detail::epoch_domain;
+
+	TEST_CLASS(epoch_domain_tests) {
+	public:
+		TEST_METHOD(construct);
+
+		TEST_METHOD(read_lock_nested);
+
+		TEST_METHOD(synchronize_frees_retired);
+
+		TEST_METHOD(reclaim_waits_for_reader);
+
+		TEST_METHOD(synchronize_waits_for_pin);
+
+		TEST_METHOD(synchronize_scoped);
+	};
+
+	struct counted {
+		explicit counted(int& count) : count{ count } {}
+		~counted() { count++; }
+
+		int& count;
+	};
+
+	void epoch_domain_tests::construct() {
+		auto& test = epoch_domain::instance();
+
+		Assert::IsTrue(&test == &epoch_domain::instance());
+	}
+
+	void epoch_domain_tests::read_lock_nested() {
+		auto& test = epoch_domain::instance();
+
+		Assert::IsFalse(test.in_read_section());
+		{
+			auto outer = test.read_lock();
+			Assert::IsTrue(test.in_read_section());
+			{
+				auto inner = test.read_lock();
+				Assert::IsTrue(test.in_read_section());
+			}
+			Assert::IsTrue(test.in_read_section());
+		}
+		Assert::IsFalse(test.in_read_section());
+	}
+
+	void epoch_domain_tests::synchronize_frees_retired() {
+		auto& test = epoch_domain::instance();
+
+		auto freed = 0;
+		test.retire(new counted{ freed });
+		test.retire(new counted{ freed });
+
+		Assert::AreEqual(0, freed);
+
+		test.synchronize();
+
+		Assert::AreEqual(2, freed);
+	}
+
+	void epoch_domain_tests::reclaim_waits_for_reader() {
+		auto& test = epoch_domain::instance();
+
+		auto freed = 0;
+		{
+			auto guard = test.read_lock();
+
+			test.retire(new counted{ freed });
+			test.reclaim();
+
+			Assert::AreEqual(0, freed);
+		}
+
+		test.reclaim();
+
+		Assert::AreEqual(1, freed);
+	}
+
+	void epoch_domain_tests::synchronize_waits_for_pin() {
+		auto& test = epoch_domain::instance();
+
+		auto pin = test.pin();
+		auto unpinned = std::atomic<bool>{ false };
+
+		auto thread = std::thread([&test, &unpinned, pin]() {
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+			unpinned = true;
+			test.unpin(pin);
+		});
+
+		test.synchronize();
+
+		Assert::IsTrue(unpinned.load());
+		thread.join();
+	}
+
+	void epoch_domain_tests::synchronize_scoped() {
+		auto& test = epoch_domain::instance();
+		auto first = 0;
+		auto second = 0;
+
+		auto pin = test.pin(&first);
+		auto unpinned = std::atomic<bool>{ false };
+
+		// a section of another scope is not waited for.
+		test.synchronize(&second);
+		Assert::IsFalse(unpinned.load());
+
+		auto thread = std::thread([&test, &unpinned, pin]() {
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+			unpinned = true;
+			test.unpin(pin);
+		});
+
+		test.synchronize(&first);
+
+		Assert::IsTrue(unpinned.load());
+		thread.join();
+	}
+}
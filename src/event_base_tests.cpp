@@ -9,6 +9,7 @@
 #include <vector>
 #include <future>
 #include <optional>
+#include <thread>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
@@ -25,8 +26,14 @@ namespace rpt::event_detail_tests {
 
 		TEST_METHOD(add_remove_listener);
 
+		TEST_METHOD(repudiate_many);
+
+		TEST_METHOD(single_listener);
+
 		TEST_METHOD(repudiate_delay);
 
+		TEST_METHOD(repudiate_other_view);
+
 		TEST_METHOD(clear_delay);
 		
 		TEST_METHOD(clear_one);
@@ -62,6 +69,64 @@ namespace rpt::event_detail_tests {
 		Assert::IsTrue(test.empty());
 	}
 
+	void event_base_tests::repudiate_many() {
+		auto test = event_base<int*>{};
+
+		auto test_liteners = std::vector<listener_base<int*>>(100, listener_base<int*>{ { [](auto&, int* count) { (*count)++; } } });
+
+		for (auto& test_litener : test_liteners)
+			test.subscribe(test_litener);
+
+		// enough to compact the array a few times on the way down.
+		for (auto i = std::size_t{ 0 }; i < test_liteners.size(); i += 2)
+			test.repudiate(test_liteners[i]);
+
+		auto count = 0;
+		test(&count);
+
+		Assert::AreEqual(50, count);
+		Assert::AreEqual<std::size_t>(50, test.view_lock().size());
+
+		for (auto i = std::size_t{ 1 }; i < test_liteners.size(); i += 2)
+			test.repudiate(test_liteners[i]);
+
+		count = 0;
+		test(&count);
+
+		Assert::AreEqual(0, count);
+		Assert::IsTrue(test.empty());
+	}
+
+	void event_base_tests::single_listener() {
+		auto test = event_base<int*>{};
+
+		auto first = listener_base<int*>{ { [](auto&, int* count) { (*count)++; } } };
+		auto second = listener_base<int*>{ { [](auto&, int* count) { (*count) += 10; } } };
+
+		auto count = 0;
+		test.subscribe(first);
+		test(&count);
+
+		Assert::AreEqual(1, count);
+		Assert::AreEqual<std::size_t>(1, test.view_lock().size());
+
+		// out to an array and back into the word, with the other listener left over.
+		test.subscribe(second);
+		test(&count);
+		Assert::AreEqual(12, count);
+
+		test.repudiate(first);
+		test(&count);
+		Assert::AreEqual(22, count);
+		Assert::AreEqual<std::size_t>(1, test.view_lock().size());
+
+		test.repudiate(second);
+		test(&count);
+		Assert::AreEqual(22, count);
+		Assert::IsTrue(test.empty());
+		Assert::AreEqual<std::size_t>(0, test.view_lock().size());
+	}
+
 	struct event_base_test_listener : listener_base<> {
 
 		event_base_test_listener()
@@ -120,7 +185,7 @@ namespace rpt::event_detail_tests {
 
 		auto view = test.view_lock();
 
-		Assert::AreEqual(1ull, view.size());
+		Assert::AreEqual<std::size_t>(1, view.size());
 
 		std::thread([view = std::move(view)]() {
 			std::this_thread::sleep_for(std::chrono::milliseconds(2));
@@ -135,6 +200,23 @@ namespace rpt::event_detail_tests {
 		Assert::IsTrue(delay > std::chrono::milliseconds(1));
 	}
 
+	void event_base_tests::repudiate_other_view() {
+		auto first = event_base<>{};
+		auto second = event_base<>{};
+
+		auto first_litener = event_base_test_listener{};
+		auto second_litener = event_base_test_listener{};
+		first.subscribe(first_litener);
+		second.subscribe(second_litener);
+
+		// a view of one event does not hold up unsubscribing from another.
+		auto view = first.view_lock();
+		second.repudiate(second_litener);
+
+		Assert::IsTrue(second.empty());
+		Assert::AreEqual<std::size_t>(1, view.size());
+	}
+
 	void event_base_tests::clear_delay() {
 		auto test = event_base<>{};
 
@@ -143,7 +225,7 @@ namespace rpt::event_detail_tests {
 
 		auto view = test.view_lock();
 
-		Assert::AreEqual(1ull, view.size());
+		Assert::AreEqual<std::size_t>(1, view.size());
 
 		std::thread([view = std::move(view)]() {
 			std::this_thread::sleep_for(std::chrono::milliseconds(2));
@@ -199,11 +281,6 @@ namespace rpt::event_detail_tests {
 			}));
 		}
 
-			{
-				auto lock = std::lock_guard(mutex);
-				Assert::IsTrue(times.empty());
-			}
-
 			//std::this_thread::sleep_for(std::chrono::milliseconds{ 40 });
 			{
 				auto waiter = std::unique_lock{ cv_mutex };
@@ -216,18 +293,17 @@ namespace rpt::event_detail_tests {
 
 			Assert::AreEqual<std::size_t>(test.view_lock().size(), thread_count);
 
-			std::this_thread::sleep_for(std::chrono::milliseconds{ 5 });
+			// subscribing does not wait for the view to be released.
+			for (auto& future : futures)
+				future.wait();
+
+			Assert::IsTrue(times.size() == thread_count);
 
 			view.reset();
 
 			//for (auto& thread : threads)
 			//	thread.join();
 
-			for (auto& future : futures)
-				future.wait();
-
-			Assert::IsTrue(times.size() == thread_count);
-
 			test_liteners.clear();
 
 			//auto lock = std::lock_guard(mutex);
@@ -241,9 +317,6 @@ namespace rpt::event_detail_tests {
 			assert(0);
 		}
 
-		for (auto& time : times)
-			Assert::IsTrue(time > std::chrono::milliseconds{ 5 });
-
 	}
 
 }
\ No newline at end of file
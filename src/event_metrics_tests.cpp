@@ -0,0 +1,134 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#include "pch.h"
+
+#include "event.hpp"
+#include "event_metrics.hpp"
+
+#include <array>
+#include <cstdint>
+#include <numeric>
+#include <optional>
+#include <string>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace rpt::event_metrics_tests {
+
+	TEST_CLASS(event_metrics_tests) {
+	public:
+		TEST_METHOD(construct);
+
+		TEST_METHOD(counters);
+
+		TEST_METHOD(fan_out);
+
+		TEST_METHOD(prometheus);
+
+		TEST_METHOD(prometheus_disabled);
+	};
+
+	void event_metrics_tests::construct() {
+		auto e = event<int>{};
+		auto metrics = e.metrics();
+
+		Assert::IsTrue(metrics.enabled);
+		Assert::AreEqual<std::uint64_t>(0, metrics.dispatches);
+		Assert::AreEqual<std::size_t>(0, metrics.listeners);
+		Assert::AreEqual<std::uint64_t>(0, metrics.arrays_allocated);
+	}
+
+	void event_metrics_tests::counters() {
+		auto e = event<int>{};
+		auto callback = [](int) {};
+
+		auto first = e.subscribe(callback);
+		auto second = std::optional<listener<decltype(callback), int>>{};
+		second.emplace(e, callback);
+		auto third = e.subscribe(callback);
+
+		for (auto i = 0; i < 5; i++)
+			e(i);
+
+		second.reset();
+
+		auto metrics = e.metrics();
+		Assert::AreEqual<std::uint64_t>(5, metrics.dispatches);
+		Assert::AreEqual<std::size_t>(2, metrics.listeners);
+
+		// the first listener lives in the event's list word, the next two need arrays and
+		// the unsubscribe leaves enough tombstones to compact into a third.
+		Assert::AreEqual<std::uint64_t>(3, metrics.arrays_allocated);
+		Assert::AreEqual<std::uint64_t>(2, metrics.arrays_retired);
+		Assert::AreEqual<std::uint64_t>(4, metrics.list_writes);
+		Assert::AreEqual<std::uint64_t>(0, metrics.write_lock_waits);
+		Assert::IsTrue(metrics.arrays_freed <= metrics.arrays_retired);
+
+		Assert::AreEqual<std::uint64_t>(1, metrics.reader_waits);
+
+		auto histogram_total = std::accumulate(metrics.dispatch_latency.begin(), metrics.dispatch_latency.end(), std::uint64_t{ 0 });
+		Assert::AreEqual<std::uint64_t>(5, histogram_total);
+
+		// arrays are freed when the epoch domain reclaims them, not when they are retired.
+		event_detail::epoch_domain::instance().synchronize();
+		Assert::AreEqual<std::uint64_t>(2, e.metrics().arrays_freed);
+	}
+
+	void event_metrics_tests::fan_out() {
+		auto e = event<int>{};
+		auto first = e.subscribe([](int) {});
+		auto second = e.subscribe([](int) {});
+
+		e.fan_out(fan_out_options{ 1, 0 }, 1);
+
+		Assert::AreEqual<std::uint64_t>(1, e.metrics().dispatches);
+	}
+
+	void event_metrics_tests::prometheus() {
+		auto metrics = event_metrics{};
+		metrics.enabled = true;
+		metrics.dispatches = 7;
+		metrics.listeners = 3;
+		metrics.write_lock_waits = 1;
+		metrics.arrays_freed = 2;
+		metrics.dispatch_latency[0] = 4;
+		metrics.dispatch_latency[2] = 2;
+		metrics.dispatch_latency[event_metrics::latency_bucket_count - 1] = 1;
+		metrics.dispatch_time = std::chrono::microseconds{ 500 };
+
+		auto text = to_prometheus("clicks", metrics);
+
+		auto contains = [&text](const std::string& line) {
+			return text.find(line) != std::string::npos;
+		};
+
+		Assert::IsTrue(contains("# TYPE rpt_event_dispatches_total counter\n"));
+		Assert::IsTrue(contains("rpt_event_dispatches_total{event=\"clicks\"} 7\n"));
+		Assert::IsTrue(contains("rpt_event_listeners{event=\"clicks\"} 3\n"));
+		Assert::IsTrue(contains("rpt_event_write_lock_waits_total{event=\"clicks\"} 1\n"));
+		Assert::IsTrue(contains("rpt_event_arrays_freed_total{event=\"clicks\"} 2\n"));
+
+		// buckets are cumulative.
+		Assert::IsTrue(contains("# TYPE rpt_event_dispatch_duration_seconds histogram\n"));
+		Assert::IsTrue(contains("rpt_event_dispatch_duration_seconds_bucket{event=\"clicks\",le=\"1.28e-07\"} 4\n"));
+		Assert::IsTrue(contains("rpt_event_dispatch_duration_seconds_bucket{event=\"clicks\",le=\"2.56e-07\"} 4\n"));
+		Assert::IsTrue(contains("rpt_event_dispatch_duration_seconds_bucket{event=\"clicks\",le=\"5.12e-07\"} 6\n"));
+		Assert::IsTrue(contains("rpt_event_dispatch_duration_seconds_bucket{event=\"clicks\",le=\"+Inf\"} 7\n"));
+		Assert::IsTrue(contains("rpt_event_dispatch_duration_seconds_sum{event=\"clicks\"} 5e-04\n"));
+		Assert::IsTrue(contains("rpt_event_dispatch_duration_seconds_count{event=\"clicks\"} 7\n"));
+
+		// every family once, a series per event.
+		auto events = std::array{ named_event_metrics{ "a", metrics }, named_event_metrics{ "say \"b\"", metrics } };
+		text = to_prometheus(events);
+		Assert::IsTrue(contains("rpt_event_dispatches_total{event=\"a\"} 7\n"));
+		Assert::IsTrue(contains("rpt_event_dispatches_total{event=\"say \\\"b\\\"\"} 7\n"));
+		Assert::AreEqual(text.find("# TYPE rpt_event_listeners"), text.rfind("# TYPE rpt_event_listeners"));
+	}
+
+	void event_metrics_tests::prometheus_disabled() {
+		auto text = to_prometheus("clicks", event_metrics{});
+		Assert::IsTrue(text.find("{event=") == std::string::npos);
+	}
+}
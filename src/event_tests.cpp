@@ -5,12 +5,19 @@
 #include "pch.h"
 
 #include "event.hpp"
+#include "subscription_batch.hpp"
 
 #include <optional>
 #include <array>
+#include <coroutine>
+#include <tuple>
 #include <memory_resource>
 #include <memory>
+#include <functional>
 #include <future>
+#include <string>
+#include <string_view>
+#include <thread>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
@@ -27,6 +34,24 @@ namespace rpt::event_tests {
 
 		TEST_METHOD(subscribe_multiple);
 
+		TEST_METHOD(dispatch_no_copy);
+
+		TEST_METHOD(post);
+
+		TEST_METHOD(post_unsubscribe_waits);
+
+		TEST_METHOD(post_self_unsubscribe);
+
+		TEST_METHOD(fan_out);
+
+		TEST_METHOD(fan_out_self_unsubscribe);
+
+		TEST_METHOD(next);
+
+		TEST_METHOD(next_destroyed_before_dispatch);
+
+		TEST_METHOD(next_concurrent_dispatch);
+
 		TEST_METHOD(allocator_construct);
 
 		TEST_METHOD(allocator_subscribe);
@@ -168,6 +193,232 @@ namespace rpt::event_tests {
 		}
 	}
 
+	struct copy_counter {
+		copy_counter(int& copies) : copies{ copies } {}
+		copy_counter(const copy_counter& other) : copies{ other.copies } { copies++; }
+
+		int& copies;
+	};
+
+	void event_tests::dispatch_no_copy() {
+		static_assert(std::is_same_v<event_detail::param_t<int>, int>);
+		static_assert(std::is_same_v<event_detail::param_t<int&>, int&>);
+		static_assert(std::is_same_v<event_detail::param_t<std::string>, const std::string&>);
+
+		auto test = rpt::event<copy_counter, std::string>{};
+
+		auto copies = 0;
+		auto seen = std::vector<const std::string*>{};
+
+		auto callback = [&seen](const copy_counter&, const std::string& s) {
+			seen.push_back(&s);
+		};
+		auto token0 = test.subscribe(callback);
+		auto token1 = test.subscribe(callback);
+		auto token2 = test.subscribe(callback);
+
+		auto payload = copy_counter{ copies };
+		test(payload, "a string long enough to need the heap");
+
+		Assert::AreEqual(0, copies);
+		Assert::AreEqual<std::size_t>(3, seen.size());
+		Assert::IsTrue(seen[0] == seen[1] && seen[1] == seen[2]);
+	}
+
+	void event_tests::post() {
+		auto test = rpt::event<int, std::string>{};
+
+		auto sum = std::atomic<int>{ 0 };
+		auto token0 = test.subscribe([&sum](int i, const std::string& s) { sum += i + static_cast<int>(s.size()); });
+		auto token1 = test.subscribe([&sum](int i, const std::string&) { sum += i; });
+
+		auto pool = rpt::executor{ 2 };
+		auto done = test.post(pool, 2, "four");
+		done.wait();
+
+		Assert::IsTrue(done.done());
+		Assert::AreEqual(8, sum.load());
+
+		test.post(3, std::string_view{ "" }).wait();
+
+		Assert::AreEqual(14, sum.load());
+		Assert::IsTrue(rpt::completion{}.done());
+	}
+
+	void event_tests::post_unsubscribe_waits() {
+		auto test = rpt::event<>{};
+
+		auto started = std::atomic<bool>{ false };
+		auto finished = std::atomic<bool>{ false };
+		auto token = get_optional_litener(test, [&]() {
+			started = true;
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+			finished = true;
+		});
+
+		auto pool = rpt::executor{ 1 };
+		auto done = test.post(pool);
+
+		while (!started.load())
+			std::this_thread::yield();
+
+		// the listener is still being called on the pool, unsubscribing has to wait for it.
+		token.reset();
+
+		Assert::IsTrue(finished.load());
+		done.wait();
+	}
+
+	void event_tests::post_self_unsubscribe() {
+		auto test = rpt::event<int>{};
+
+		auto calls = std::atomic<int>{ 0 };
+		auto token = std::optional<rpt::listener<std::function<void(int)>, int>>{};
+		token.emplace(test, std::function<void(int)>{ [&](int) {
+			calls++;
+			token.reset();
+		} });
+
+		auto pool = rpt::executor{ 1 };
+		test.post(pool, 1).wait();
+
+		Assert::IsFalse(token.has_value());
+		test.post(pool, 1).wait();
+		Assert::AreEqual(1, calls.load());
+	}
+
+	void event_tests::fan_out() {
+		auto test = rpt::event<int>{};
+
+		auto calls = std::vector<std::atomic<int>>(1000);
+		auto listeners = std::vector<std::optional<rpt::listener<std::function<void(int)>, int>>>(calls.size());
+		{
+			auto batch = rpt::subscription_batch{ test };
+			for (auto i = std::size_t{ 0 }; i < calls.size(); i++)
+				listeners[i].emplace(batch, std::function<void(int)>{ [&count = calls[i]](int value) { count += value; } });
+		}
+
+		auto pool = rpt::executor{ 3 };
+
+		// below the threshold, all on this thread.
+		test.fan_out(pool, rpt::fan_out_options{ 64, 2000 }, 1);
+		// 16 chunks, the last one short.
+		test.fan_out(pool, rpt::fan_out_options{ 64, 0 }, 2);
+		// one listener per chunk with a tombstone in the middle.
+		listeners[500].reset();
+		test.fan_out(pool, rpt::fan_out_options{ 1, 0 }, 4);
+
+		for (auto i = std::size_t{ 0 }; i < calls.size(); i++)
+			Assert::AreEqual(i == 500 ? 3 : 7, calls[i].load());
+	}
+
+	struct test_coroutine {
+		struct promise_type {
+			test_coroutine get_return_object() { return { std::coroutine_handle<promise_type>::from_promise(*this) }; }
+			std::suspend_never initial_suspend() noexcept { return {}; }
+			std::suspend_always final_suspend() noexcept { return {}; }
+			void return_void() {}
+			void unhandled_exception() { std::terminate(); }
+		};
+
+		std::coroutine_handle<promise_type> handle;
+	};
+
+	test_coroutine await_next(rpt::event<int, std::string>& e, std::tuple<int, std::string>& out) {
+		out = co_await e.next();
+	}
+
+	test_coroutine count_next(rpt::event<>& e, std::atomic<int>& resumed) {
+		co_await e.next();
+		resumed++;
+	}
+
+	void event_tests::fan_out_self_unsubscribe() {
+		auto test = rpt::event<int>{};
+
+		auto calls = std::atomic<int>{ 0 };
+		auto listeners = std::vector<std::optional<rpt::listener<std::function<void(int)>, int>>>(16);
+		for (auto& l : listeners) {
+			l.emplace(test, std::function<void(int)>{ [&calls, &l](int) {
+				calls++;
+				l.reset();
+			} });
+		}
+
+		// a chunk per listener, every one of them destroys itself on whichever thread runs it.
+		auto pool = rpt::executor{ 2 };
+		test.fan_out(pool, rpt::fan_out_options{ 1, 0 }, 1);
+		Assert::AreEqual(16, calls.load());
+
+		test.fan_out(pool, rpt::fan_out_options{ 1, 0 }, 1);
+		Assert::AreEqual(16, calls.load());
+		Assert::IsTrue(event_detail::get_event_base<int>::get(test).empty());
+	}
+
+	void event_tests::next() {
+		auto test = rpt::event<int, std::string>{};
+		auto out = std::tuple<int, std::string>{};
+
+		auto coroutine = await_next(test, out);
+
+		Assert::IsFalse(coroutine.handle.done());
+
+		test(4, "four");
+
+		Assert::IsTrue(coroutine.handle.done());
+		Assert::AreEqual(4, std::get<0>(out));
+		Assert::IsTrue(std::get<1>(out) == "four");
+
+		// only the first dispatch is seen.
+		test(5, "five");
+
+		Assert::AreEqual(4, std::get<0>(out));
+
+		coroutine.handle.destroy();
+	}
+
+	void event_tests::next_destroyed_before_dispatch() {
+		auto test = rpt::event<>{};
+		auto resumed = std::atomic<int>{ 0 };
+
+		auto coroutine = count_next(test, resumed);
+		coroutine.handle.destroy();
+
+		test();
+
+		Assert::AreEqual(0, resumed.load());
+
+		// left waiting when the event goes away.
+		auto dangling = std::optional<rpt::event<>>{ std::in_place };
+		auto orphan = count_next(*dangling, resumed);
+		dangling.reset();
+		orphan.handle.destroy();
+
+		Assert::AreEqual(0, resumed.load());
+	}
+
+	void event_tests::next_concurrent_dispatch() {
+		auto test = rpt::event<>{};
+		auto resumed = std::atomic<int>{ 0 };
+
+		auto coroutines = std::vector<test_coroutine>{};
+		for (auto i = 0; i < 100; i++)
+			coroutines.push_back(count_next(test, resumed));
+
+		auto threads = std::vector<std::thread>{};
+		for (auto i = 0; i < 4; i++)
+			threads.emplace_back([&test]() { test(); });
+		for (auto& thread : threads)
+			thread.join();
+
+		Assert::AreEqual(100, resumed.load());
+
+		for (auto& coroutine : coroutines) {
+			Assert::IsTrue(coroutine.handle.done());
+			coroutine.handle.destroy();
+		}
+	}
+
 	void event_tests::allocator_construct() {
 
 		std::array<std::uint8_t, 304> buffer{};
@@ -190,7 +441,13 @@ namespace rpt::event_tests {
 		decltype(pre_l_buffer_size) post_l_buffer_size;
 
 		{
-			auto l = e.subscribe([]() {
+			auto l1 = e.subscribe([]() {
+			});
+
+			// a single listener is kept inline, no array is allocated.
+			Assert::AreEqual(pre_l_buffer_size, buffer.size() - std::count(buffer.begin(), buffer.end(), 0));
+
+			auto l2 = e.subscribe([]() {
 			});
 
 			post_l_buffer_size = buffer.size() - std::count(buffer.begin(), buffer.end(), 0);
@@ -200,7 +457,9 @@ namespace rpt::event_tests {
 
 		auto post_destruct_l_buffer_size = buffer.size() - std::count(buffer.begin(), buffer.end(), 0);
 
-		Assert::AreNotEqual(post_l_buffer_size, post_destruct_l_buffer_size);
+		// dropping back to one listener and then none needs no new array either,
+		// the only write is the tombstone over the second entry.
+		Assert::IsTrue(post_destruct_l_buffer_size <= post_l_buffer_size);
 	}
 
 	void event_tests::abuse_test() {
@@ -0,0 +1,153 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#include "pch.h"
+
+#include "executor.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace rpt::executor_tests {
+
+	TEST_CLASS(executor_tests) {
+	public:
+		TEST_METHOD(construct);
+
+		TEST_METHOD(submit_many);
+
+		TEST_METHOD(submit_from_worker);
+
+		TEST_METHOD(steal_from_blocked_worker);
+
+		TEST_METHOD(destruct_drains);
+
+		TEST_METHOD(large_task);
+
+		TEST_METHOD(submit_when_full);
+	};
+
+	void executor_tests::construct() {
+		auto test = executor{ 2 };
+
+		Assert::AreEqual<std::size_t>(2, test.size());
+		Assert::IsFalse(test.running_in_this_thread());
+		Assert::IsTrue(&executor::instance() == &executor::instance());
+	}
+
+	void executor_tests::submit_many() {
+		auto count = std::atomic<int>{ 0 };
+		{
+			auto test = executor{ 4 };
+			for (auto i = 0; i < 1000; i++)
+				test.submit([&count]() { count++; });
+		}
+
+		Assert::AreEqual(1000, count.load());
+	}
+
+	void executor_tests::submit_from_worker() {
+		auto count = std::atomic<int>{ 0 };
+		auto on_worker = std::atomic<bool>{ false };
+		{
+			auto test = executor{ 2 };
+			test.submit([&]() {
+				on_worker = test.running_in_this_thread();
+				for (auto i = 0; i < 10; i++)
+					test.submit([&count]() { count++; });
+			});
+		}
+
+		Assert::IsTrue(on_worker.load());
+		Assert::AreEqual(10, count.load());
+	}
+
+	void executor_tests::steal_from_blocked_worker() {
+		auto release = std::atomic<bool>{ false };
+		auto count = std::atomic<int>{ 0 };
+
+		auto test = executor{ 2 };
+
+		// the first worker parks itself and queues more work behind it on its own ring.
+		test.submit([&]() {
+			for (auto i = 0; i < 10; i++)
+				test.submit([&count]() { count++; });
+			while (!release.load())
+				std::this_thread::yield();
+		});
+
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+		while (count.load() != 10 && std::chrono::steady_clock::now() < deadline)
+			std::this_thread::yield();
+
+		Assert::AreEqual(10, count.load());
+
+		release = true;
+	}
+
+	void executor_tests::destruct_drains() {
+		auto count = std::atomic<int>{ 0 };
+		{
+			auto test = executor{ 1 };
+			test.submit([&count]() {
+				std::this_thread::sleep_for(std::chrono::milliseconds(2));
+				count++;
+			});
+			test.submit([&count]() { count++; });
+		}
+
+		Assert::AreEqual(2, count.load());
+	}
+
+	void executor_tests::large_task() {
+		auto sum = std::atomic<int>{ 0 };
+		{
+			auto test = executor{ 1 };
+
+			// too large for the inline buffer, so it is allocated.
+			auto values = std::array<int, 32>{};
+			values.fill(1);
+			static_assert(sizeof(values) > executor::task_type::inline_size);
+
+			test.submit([&sum, values]() {
+				for (auto value : values)
+					sum += value;
+			});
+		}
+
+		Assert::AreEqual(32, sum.load());
+	}
+
+	void executor_tests::submit_when_full() {
+		auto release = std::atomic<bool>{ false };
+		auto count = std::atomic<int>{ 0 };
+		auto on_submitter = std::atomic<int>{ 0 };
+		{
+			auto test = executor{ 1 };
+			test.submit([&release]() {
+				while (!release.load())
+					std::this_thread::yield();
+			});
+
+			// the only worker is blocked, once its ring is full tasks run right here.
+			constexpr auto submitted = static_cast<int>(executor::queue_capacity) * 2;
+			for (auto i = 0; i < submitted; i++) {
+				test.submit([&]() {
+					if (!test.running_in_this_thread())
+						on_submitter++;
+					count++;
+				});
+			}
+
+			Assert::IsTrue(on_submitter.load() > 0);
+			release = true;
+		}
+
+		Assert::AreEqual(static_cast<int>(executor::queue_capacity) * 2, count.load());
+	}
+}
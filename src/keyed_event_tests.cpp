@@ -0,0 +1,157 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#include "pch.h"
+
+#include "keyed_event.hpp"
+#include "subscription_batch.hpp"
+
+#include <atomic>
+#include <functional>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace rpt::keyed_event_tests {
+
+	TEST_CLASS(keyed_event_tests) {
+	public:
+		TEST_METHOD(construct);
+
+		TEST_METHOD(dispatch_by_key);
+
+		TEST_METHOD(unsubscribe_one_key);
+
+		TEST_METHOD(many_keys);
+
+		TEST_METHOD(batch);
+
+		TEST_METHOD(concurrent_subscribe_dispatch);
+	};
+
+	void keyed_event_tests::construct() {
+		auto test = keyed_event<std::string, int>{};
+
+		Assert::AreEqual<std::size_t>(0, test.key_count());
+		Assert::IsNull(test.find("a"));
+
+		// dispatching a key nobody subscribed to does not create it.
+		test("a", 1);
+		Assert::AreEqual<std::size_t>(0, test.key_count());
+	}
+
+	void keyed_event_tests::dispatch_by_key() {
+		auto test = keyed_event<std::string, int>{};
+
+		auto a = 0;
+		auto b = 0;
+		auto la = test.subscribe("a", [&a](int i) { a += i; });
+		auto lb = test.subscribe("b", [&b](int i) { b += i; });
+		auto lb2 = test.subscribe("b", [&b](int i) { b += i; });
+
+		test("a", 1);
+		Assert::AreEqual(1, a);
+		Assert::AreEqual(0, b);
+
+		test("b", 2);
+		Assert::AreEqual(1, a);
+		Assert::AreEqual(4, b);
+
+		test("c", 3);
+		Assert::AreEqual(1, a);
+		Assert::AreEqual(4, b);
+
+		Assert::AreEqual<std::size_t>(2, test.key_count());
+		Assert::IsTrue(test.find("a") == &test.get_event("a"));
+	}
+
+	void keyed_event_tests::unsubscribe_one_key() {
+		auto test = keyed_event<int, int>{};
+
+		auto a = 0;
+		auto b = 0;
+		auto lb = test.subscribe(2, [&b](int i) { b += i; });
+		{
+			auto la = test.subscribe(1, [&a](int i) { a += i; });
+			test(1, 1);
+		}
+
+		test(1, 1);
+		test(2, 1);
+
+		Assert::AreEqual(1, a);
+		Assert::AreEqual(1, b);
+
+		// the key stays, without listeners.
+		Assert::AreEqual<std::size_t>(2, test.key_count());
+	}
+
+	void keyed_event_tests::many_keys() {
+		constexpr auto count = 1000;
+
+		auto test = keyed_event<int, int>{};
+
+		auto seen = std::vector<int>(count, 0);
+		auto listeners = std::vector<std::optional<listener<std::function<void(int)>, int>>>(count);
+		for (auto i = 0; i < count; i++)
+			listeners[i].emplace(test.get_event(i), [&seen, i](int x) { seen[i] += x; });
+
+		Assert::AreEqual<std::size_t>(count, test.key_count());
+
+		for (auto i = 0; i < count; i++)
+			test(i, i);
+
+		for (auto i = 0; i < count; i++)
+			Assert::AreEqual(i, seen[i]);
+	}
+
+	void keyed_event_tests::batch() {
+		auto test = keyed_event<int, int>{};
+
+		auto total = 0;
+		{
+			auto batch = subscription_batch{ test.get_event(7) };
+			auto l1 = batch.subscribe([&total](int i) { total += i; });
+			auto l2 = batch.subscribe([&total](int i) { total += i; });
+			batch.commit();
+
+			test(7, 3);
+		}
+		test(7, 3);
+
+		Assert::AreEqual(6, total);
+	}
+
+	void keyed_event_tests::concurrent_subscribe_dispatch() {
+		constexpr auto key_count = 256;
+
+		auto test = keyed_event<int, int>{};
+
+		auto total = std::atomic<int>{ 0 };
+		auto first = test.subscribe(0, [&total](int i) { total += i; });
+
+		auto stop = std::atomic<bool>{ false };
+		auto dispatcher = std::thread([&]() {
+			while (!stop.load())
+				test(0, 1);
+		});
+
+		// growing the index while key 0 is looked up on the other thread.
+		auto listeners = std::vector<std::optional<listener<std::function<void(int)>, int>>>(key_count);
+		for (auto i = 1; i < key_count; i++)
+			listeners[i].emplace(test.get_event(i), [&total](int x) { total += x; });
+
+		stop = true;
+		dispatcher.join();
+
+		auto before = total.load();
+		for (auto i = 1; i < key_count; i++)
+			test(i, 1);
+
+		Assert::AreEqual(before + key_count - 1, total.load());
+	}
+}
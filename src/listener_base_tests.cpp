@@ -27,7 +27,7 @@ namespace rpt::event_detail_tests {
 		auto test_int = listener_base<int>{ { [](auto p, auto i) {} } };
 		auto test_double = listener_base<double>{ { [](auto p, auto d) {} } };
 		auto test_pack = listener_base<int, int, double, std::string>{ {
-			[](auto, int, int, double, std::string) {}
+			[](auto, int, int, double, const std::string&) {}
 		} };
 	}
 
@@ -7,6 +7,15 @@
 #include "listener.hpp"
 #include "event.hpp"
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
 namespace rpt::event_tests {
@@ -14,6 +23,20 @@ namespace rpt::event_tests {
     TEST_CLASS(listener_tests) {
 	public:
 		TEST_METHOD(destruct_callback);
+
+		TEST_METHOD(detach);
+
+		TEST_METHOD(detach_in_callback);
+
+		TEST_METHOD(destroy_in_callback);
+
+		TEST_METHOD(destroy_in_callback_waits);
+
+		TEST_METHOD(destroy_in_callback_both_threads);
+
+		TEST_METHOD(detach_in_callback_while_destroyed);
+
+		TEST_METHOD(subscribe_in_callback);
 	};
 
 	void listener_tests::destruct_callback() {
@@ -47,4 +70,180 @@ namespace rpt::event_tests {
 		Assert::IsTrue(test_int_value == 0);
 	}
 
-}
\ No newline at end of file
+
+	void listener_tests::detach() {
+		auto test_int = rpt::event<int>{};
+
+		auto test_int_value{ 0 };
+		auto token_int = rpt::listener(test_int, [&test_int_value](int i) {
+			test_int_value += i;
+		});
+
+		test_int(1);
+		token_int.detach();
+		test_int(1);
+		Assert::AreEqual(1, test_int_value);
+
+		// a second detach does nothing.
+		token_int.detach();
+		Assert::IsTrue(event_detail::get_event_base<int>::get(test_int).empty());
+	}
+
+	void listener_tests::detach_in_callback() {
+		auto test_int = rpt::event<int>{};
+
+		auto calls{ 0 };
+		auto token_int = std::optional<rpt::listener<std::function<void(int)>, int>>{};
+		token_int.emplace(test_int, std::function<void(int)>{ [&calls, &token_int](int) {
+			calls++;
+			token_int->detach();
+		} });
+
+		test_int(1);
+		test_int(1);
+		Assert::AreEqual(1, calls);
+
+		// the destructor still waits, it is run outside of any dispatch.
+		token_int.reset();
+	}
+
+	void listener_tests::destroy_in_callback() {
+		auto test_int = rpt::event<int>{};
+
+		auto calls{ 0 };
+		auto callback = std::function<void(int)>{};
+		using listener_type = rpt::listener<std::function<void(int)>, int>;
+
+		auto token_int = std::optional<listener_type>{};
+		auto other = std::optional<listener_type>{};
+		callback = [&](int) {
+			calls++;
+			token_int.reset();
+		};
+
+		token_int.emplace(test_int, callback);
+		other.emplace(test_int, [&calls](int) { calls += 10; });
+
+		test_int(1);
+		Assert::IsFalse(token_int.has_value());
+		Assert::AreEqual(11, calls);
+
+		test_int(1);
+		Assert::AreEqual(21, calls);
+	}
+
+	void listener_tests::destroy_in_callback_waits() {
+		auto test_int = rpt::event<int>{};
+		using listener_type = rpt::listener<std::function<void(int)>, int>;
+
+		auto inside = std::atomic<bool>{ false };
+		auto left = std::atomic<bool>{ false };
+		auto left_when_destroyed = false;
+
+		auto token_int = std::optional<listener_type>{};
+		token_int.emplace(test_int, std::function<void(int)>{ [&](int i) {
+			if (i != 2)
+				return;
+			inside = true;
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			left = true;
+		} });
+
+		// destroyed from a dispatch on this thread while the other is still inside its callback.
+		auto other = rpt::listener(test_int, [&](int i) {
+			if (i != 1)
+				return;
+			token_int.reset();
+			left_when_destroyed = left.load();
+		});
+
+		auto thread = std::thread([&test_int]() { test_int(2); });
+		while (!inside.load())
+			std::this_thread::yield();
+
+		test_int(1);
+		Assert::IsTrue(left_when_destroyed);
+
+		thread.join();
+	}
+
+	void listener_tests::destroy_in_callback_both_threads() {
+		auto test_int = rpt::event<int>{};
+		using listener_type = rpt::listener<std::function<void(int)>, int>;
+
+		auto tokens = std::array<std::optional<listener_type>, 2>{};
+		auto inside = std::array<std::atomic<bool>, 2>{};
+		auto calls = std::atomic<int>{ 0 };
+
+		// each thread destroys its own listener while the other is still dispatching.
+		for (auto i = 0; i < 2; i++) {
+			tokens[i].emplace(test_int, std::function<void(int)>{ [&, i](int value) {
+				calls++;
+				if (value != i)
+					return;
+				inside[i] = true;
+				while (!inside[1 - i].load())
+					std::this_thread::yield();
+				tokens[i].reset();
+			} });
+		}
+
+		auto thread = std::thread([&test_int]() { test_int(1); });
+		test_int(0);
+		thread.join();
+
+		Assert::IsFalse(tokens[0].has_value());
+		Assert::IsFalse(tokens[1].has_value());
+		Assert::IsTrue(calls.load() <= 4);
+	}
+
+	void listener_tests::detach_in_callback_while_destroyed() {
+		auto test_int = rpt::event<int>{};
+		using listener_type = rpt::listener<std::function<void(int)>, int>;
+
+		// the owner destroys the listener while its callback is detaching it on another thread.
+		for (auto round = 0; round < 100; round++) {
+			auto detaching = std::atomic<bool>{ false };
+			auto left = std::atomic<bool>{ false };
+
+			auto token_int = std::optional<listener_type>{};
+			auto self = static_cast<listener_type*>(nullptr);
+			token_int.emplace(test_int, std::function<void(int)>{ [&](int) {
+				detaching = true;
+				self->detach();
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				left = true;
+			} });
+			self = &*token_int;
+
+			auto thread = std::thread([&test_int]() { test_int(1); });
+			while (!detaching.load())
+				std::this_thread::yield();
+
+			token_int.reset();
+			auto left_when_destroyed = left.load();
+			thread.join();
+
+			Assert::IsTrue(left_when_destroyed);
+		}
+	}
+
+	void listener_tests::subscribe_in_callback() {
+		auto test_int = rpt::event<int>{};
+
+		auto added = std::vector<std::unique_ptr<rpt::listener<std::function<void(int)>, int>>>{};
+		auto calls{ 0 };
+
+		auto token_int = rpt::listener(test_int, [&](int) {
+			if (added.size() < 3)
+				added.push_back(std::make_unique<rpt::listener<std::function<void(int)>, int>>(test_int, std::function<void(int)>{ [&calls](int) { calls++; } }));
+		});
+
+		test_int(1);
+		Assert::AreEqual(1, static_cast<int>(added.size()));
+
+		test_int(1);
+		Assert::AreEqual(2, static_cast<int>(added.size()));
+		Assert::AreEqual(1, calls);
+	}
+}
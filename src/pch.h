@@ -0,0 +1,14 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#ifndef RPT_TESTS_PCH
+#define RPT_TESTS_PCH
+
+#if defined(_MSC_VER)
+#include "CppUnitTest.h"
+#else
+#include "unit_test.hpp"
+#endif
+
+#endif // RPT_TESTS_PCH
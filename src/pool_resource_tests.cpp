@@ -0,0 +1,299 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#include "pch.h"
+
+#include "event.hpp"
+#include "pool_resource.hpp"
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <cstdlib>
+#include <memory_resource>
+#include <new>
+#include <optional>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace {
+	thread_local bool counting{ false };
+	thread_local std::size_t allocations{ 0 };
+}
+
+// global allocations made by the calling thread are counted while counting is set.
+void* operator new(std::size_t size) {
+	if (counting)
+		allocations++;
+	if (auto ptr = std::malloc(size ? size : 1))
+		return ptr;
+	throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size) {
+	return ::operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+
+namespace rpt::pool_resource_tests {
+
+	TEST_CLASS(pool_resource_tests) {
+	public:
+		TEST_METHOD(construct);
+
+		TEST_METHOD(reuse);
+
+		TEST_METHOD(alignment);
+
+		TEST_METHOD(large);
+
+		TEST_METHOD(single_shard);
+
+		TEST_METHOD(event_default);
+
+		TEST_METHOD(event_churn_no_heap);
+
+		TEST_METHOD(next_no_heap);
+
+		TEST_METHOD(threads);
+
+		TEST_METHOD(cross_thread_bounded);
+	};
+
+	void pool_resource_tests::construct() {
+		auto test = pool_resource{};
+		auto stats = test.stats();
+
+		Assert::AreEqual<std::size_t>(0, stats.allocations);
+		Assert::AreEqual<std::size_t>(0, stats.bytes_reserved);
+		Assert::IsTrue(test.is_equal(test));
+		Assert::IsFalse(test.is_equal(*std::pmr::new_delete_resource()));
+	}
+
+	void pool_resource_tests::reuse() {
+		auto test = pool_resource{};
+
+		auto first = test.allocate(40);
+		test.deallocate(first, 40);
+
+		// same size class, same block.
+		auto second = test.allocate(64);
+		Assert::IsTrue(first == second);
+
+		auto stats = test.stats();
+		Assert::AreEqual<std::size_t>(2, stats.allocations);
+		Assert::AreEqual<std::size_t>(1, stats.deallocations);
+		Assert::AreEqual<std::size_t>(1, stats.pooled_allocations);
+		Assert::AreEqual<std::size_t>(1, stats.upstream_allocations);
+		Assert::AreEqual<std::size_t>(64, stats.bytes_in_use);
+		Assert::AreEqual<std::size_t>(64 * test.options().blocks_per_slab, stats.bytes_reserved);
+
+		test.deallocate(second, 64);
+		Assert::AreEqual<std::size_t>(0, test.stats().bytes_in_use);
+	}
+
+	void pool_resource_tests::alignment() {
+		auto test = pool_resource{};
+
+		for (auto align : { 1, 2, 4, 8, 16, 32, 64 }) {
+			auto p = test.allocate(8, align);
+			Assert::AreEqual<std::uintptr_t>(0, reinterpret_cast<std::uintptr_t>(p) % align);
+			test.deallocate(p, 8, align);
+		}
+	}
+
+	void pool_resource_tests::large() {
+		auto test = pool_resource{};
+
+		auto p = test.allocate(pool_resource::max_block_size + 1);
+		auto stats = test.stats();
+
+		Assert::AreEqual<std::size_t>(1, stats.upstream_allocations);
+		Assert::AreEqual<std::size_t>(pool_resource::max_block_size + 1, stats.bytes_in_use);
+
+		test.deallocate(p, pool_resource::max_block_size + 1);
+		Assert::AreEqual<std::size_t>(0, test.stats().bytes_in_use);
+	}
+
+	void pool_resource_tests::single_shard() {
+		auto test = pool_resource{ pool_options{ false, 4 } };
+
+		auto blocks = std::vector<void*>{};
+		for (auto i = 0; i < 9; i++)
+			blocks.push_back(test.allocate(16));
+
+		Assert::AreEqual<std::size_t>(3, test.stats().upstream_allocations);
+
+		for (auto p : blocks)
+			test.deallocate(p, 16);
+	}
+
+	void pool_resource_tests::event_default() {
+		auto before = pool_resource::instance().stats().allocations;
+		{
+			auto e = event<int>{};
+			auto l1 = e.subscribe([](int) {});
+			auto l2 = e.subscribe([](int) {});
+			e(1);
+		}
+
+		// the second listener moves the list into an array from the pool.
+		Assert::IsTrue(pool_resource::instance().stats().allocations > before);
+	}
+
+	void pool_resource_tests::event_churn_no_heap() {
+		auto e = event<int>{};
+		auto callback = [](int) {};
+		using listener_type = listener<decltype(callback), int>;
+
+		auto first = e.subscribe(callback);
+		auto second = e.subscribe(callback);
+		auto churned = std::optional<listener_type>{};
+
+		auto churn = [&](int rounds) {
+			for (auto i = 0; i < rounds; i++) {
+				churned.emplace(e, callback);
+				e(i);
+				churned.reset();
+			}
+		};
+
+		// the pool, the epoch domain and this thread's record are set up on the way in.
+		churn(1000);
+
+		counting = true;
+		churn(1000);
+		counting = false;
+
+		Assert::AreEqual<std::size_t>(0, allocations);
+	}
+
+	struct next_coroutine {
+		struct promise_type {
+			next_coroutine get_return_object() { return { std::coroutine_handle<promise_type>::from_promise(*this) }; }
+			std::suspend_never initial_suspend() noexcept { return {}; }
+			std::suspend_always final_suspend() noexcept { return {}; }
+			void return_void() {}
+			void unhandled_exception() { std::terminate(); }
+		};
+
+		std::coroutine_handle<promise_type> handle;
+	};
+
+	next_coroutine await_forever(event<int>& e, int& last) {
+		while (true)
+			last = std::get<0>(co_await e.next());
+	}
+
+	void pool_resource_tests::next_no_heap() {
+		auto e = event<int>{};
+		auto callback = [](int) {};
+
+		auto first = e.subscribe(callback);
+		auto second = e.subscribe(callback);
+
+		auto last = -1;
+		auto coroutine = await_forever(e, last);
+
+		// every dispatch resumes the coroutine, which waits on the next one again.
+		for (auto i = 0; i < 1000; i++)
+			e(i);
+
+		counting = true;
+		for (auto i = 0; i < 1000; i++)
+			e(i);
+		counting = false;
+
+		Assert::AreEqual<std::size_t>(0, allocations);
+		Assert::AreEqual(999, last);
+
+		coroutine.handle.destroy();
+	}
+
+	void pool_resource_tests::threads() {
+		constexpr auto thread_count = 4;
+		constexpr auto rounds = 10000;
+
+		auto test = pool_resource{};
+
+		// blocks allocated on one thread and freed on another move between shards.
+		auto handoff = std::vector<std::vector<void*>>(thread_count);
+		for (auto& blocks : handoff) {
+			for (auto i = 0; i < rounds; i++)
+				blocks.push_back(test.allocate(static_cast<std::size_t>(16 + i % 200)));
+		}
+
+		auto threads = std::vector<std::thread>{};
+		for (auto t = 0; t < thread_count; t++) {
+			threads.emplace_back([&test, &blocks = handoff[t]]() {
+				for (auto i = 0; i < rounds; i++) {
+					test.deallocate(blocks[i], static_cast<std::size_t>(16 + i % 200));
+					auto p = test.allocate(32);
+					test.deallocate(p, 32);
+				}
+			});
+		}
+		for (auto& thread : threads)
+			thread.join();
+
+		auto stats = test.stats();
+		Assert::AreEqual<std::size_t>(0, stats.bytes_in_use);
+		Assert::AreEqual(stats.allocations, stats.deallocations);
+	}
+
+	void pool_resource_tests::cross_thread_bounded() {
+		constexpr auto rounds = 1000;
+		constexpr auto batch = 64;
+
+		auto test = pool_resource{ pool_options{ true, 32, std::pmr::new_delete_resource(), 4 } };
+
+		// one thread only allocates and the other only frees, the freed blocks have to find their way back.
+		auto blocks = std::vector<void*>(batch);
+		auto turn = std::atomic<int>{ 0 };
+
+		auto producer = std::thread{ [&]() {
+			for (auto r = 0; r < rounds; r++) {
+				turn.wait(1);
+				for (auto& p : blocks)
+					p = test.allocate(64);
+				turn = 1;
+				turn.notify_one();
+			}
+		} };
+		auto consumer = std::thread{ [&]() {
+			for (auto r = 0; r < rounds; r++) {
+				turn.wait(0);
+				for (auto p : blocks)
+					test.deallocate(p, 64);
+				turn = 0;
+				turn.notify_one();
+			}
+		} };
+		producer.join();
+		consumer.join();
+
+		auto stats = test.stats();
+		Assert::AreEqual<std::size_t>(0, stats.bytes_in_use);
+		Assert::AreEqual(stats.allocations, stats.deallocations);
+		Assert::IsTrue(stats.bytes_reserved <= 4 * 64 * test.options().blocks_per_slab);
+	}
+}
@@ -0,0 +1,291 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#include "pch.h"
+
+#include "queued_event.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace {
+	std::atomic<std::size_t> allocations{ 0 };
+
+	void* aligned_allocate(std::size_t size, std::align_val_t alignment) {
+		auto align = static_cast<std::size_t>(alignment);
+#if defined(_WIN32)
+		return _aligned_malloc(size ? size : 1, align);
+#else
+		return std::aligned_alloc(align, ((size ? size : 1) + align - 1) / align * align);
+#endif
+	}
+
+	void aligned_free(void* ptr) {
+#if defined(_WIN32)
+		_aligned_free(ptr);
+#else
+		std::free(ptr);
+#endif
+	}
+}
+
+// every test in this executable counts global allocations, through every replaceable form
+// of new: plain, array, aligned and nothrow. the deletes match them.
+void* operator new(std::size_t size) {
+	allocations++;
+	if (auto ptr = std::malloc(size ? size : 1))
+		return ptr;
+	throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size) {
+	return ::operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+	allocations++;
+	return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+	return ::operator new(size, tag);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+	allocations++;
+	if (auto ptr = aligned_allocate(size, alignment))
+		return ptr;
+	throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+	return ::operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	allocations++;
+	return aligned_allocate(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t& tag) noexcept {
+	return ::operator new(size, alignment, tag);
+}
+
+void operator delete(void* ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+	aligned_free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+	aligned_free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+	aligned_free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept {
+	aligned_free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+	aligned_free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+	aligned_free(ptr);
+}
+
+namespace rpt::queued_event_tests {
+
+	TEST_CLASS(queued_event_tests) {
+	public:
+		TEST_METHOD(construct);
+
+		TEST_METHOD(dispatch_in_order);
+
+		TEST_METHOD(queue_without_allocating);
+
+		TEST_METHOD(drop_newest);
+
+		TEST_METHOD(drop_oldest);
+
+		TEST_METHOD(overwrite);
+
+		TEST_METHOD(block);
+
+		TEST_METHOD(many_producers);
+	};
+
+	void queued_event_tests::construct() {
+		auto test = queued_event<int>{ 5 };
+
+		Assert::AreEqual<std::size_t>(8, test.capacity());
+		Assert::AreEqual<std::size_t>(0, test.pending());
+		Assert::IsTrue(test.policy() == overflow_policy::block);
+	}
+
+	void queued_event_tests::dispatch_in_order() {
+		auto test = queued_event<int, std::string>{ 8 };
+
+		auto seen = std::vector<int>{};
+		auto l = test.subscribe([&seen](int i, const std::string& s) {
+			seen.push_back(i + static_cast<int>(s.size()));
+		});
+
+		test(1, "");
+		test(2, "a");
+		test(3, "ab");
+
+		// nothing runs on the producer.
+		Assert::IsTrue(seen.empty());
+		Assert::AreEqual<std::size_t>(3, test.pending());
+
+		Assert::AreEqual<std::size_t>(2, test.dispatch_pending(2));
+		Assert::AreEqual<std::size_t>(1, test.dispatch_pending());
+		Assert::AreEqual<std::size_t>(0, test.dispatch_pending());
+
+		Assert::IsTrue(seen == std::vector<int>{ 1, 3, 5 });
+	}
+
+	void queued_event_tests::queue_without_allocating() {
+		// the ring's slots are over aligned, so this also checks the aligned forms are counted.
+		auto constructed = allocations.load();
+		auto test = queued_event<int, double>{ 64 };
+		Assert::IsTrue(allocations.load() > constructed);
+
+		auto before = allocations.load();
+		for (auto i = 0; i < 64; i++)
+			test(i, 0.5);
+
+		Assert::AreEqual(before, allocations.load());
+		Assert::AreEqual<std::size_t>(64, test.pending());
+	}
+
+	void queued_event_tests::drop_newest() {
+		auto test = queued_event<int>{ 2, overflow_policy::drop_newest };
+
+		auto seen = std::vector<int>{};
+		auto l = test.subscribe([&seen](int i) { seen.push_back(i); });
+
+		Assert::IsTrue(test(1));
+		Assert::IsTrue(test(2));
+		Assert::IsFalse(test(3));
+
+		test.dispatch_pending();
+
+		Assert::IsTrue(seen == std::vector<int>{ 1, 2 });
+	}
+
+	void queued_event_tests::drop_oldest() {
+		auto test = queued_event<int>{ 2, overflow_policy::drop_oldest };
+
+		auto seen = std::vector<int>{};
+		auto l = test.subscribe([&seen](int i) { seen.push_back(i); });
+
+		for (auto i = 1; i <= 5; i++)
+			Assert::IsTrue(test(i));
+
+		test.dispatch_pending();
+
+		Assert::IsTrue(seen == std::vector<int>{ 4, 5 });
+	}
+
+	void queued_event_tests::overwrite() {
+		auto test = queued_event<int>{ 2, overflow_policy::overwrite };
+
+		auto seen = std::vector<int>{};
+		auto l = test.subscribe([&seen](int i) { seen.push_back(i); });
+
+		for (auto i = 1; i <= 5; i++)
+			Assert::IsTrue(test(i));
+
+		test.dispatch_pending();
+
+		Assert::IsTrue(seen == std::vector<int>{ 1, 5 });
+	}
+
+	void queued_event_tests::block() {
+		auto test = queued_event<int>{ 2, overflow_policy::block };
+
+		auto sum = 0;
+		auto l = test.subscribe([&sum](int i) { sum += i; });
+
+		test(1);
+		test(2);
+
+		auto finished = std::atomic<bool>{ false };
+		auto producer = std::thread([&]() {
+			test(3);
+			finished = true;
+		});
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		Assert::IsFalse(finished.load());
+
+		while (!finished.load())
+			test.dispatch_pending(1);
+		producer.join();
+		test.dispatch_pending();
+
+		Assert::AreEqual(6, sum);
+	}
+
+	void queued_event_tests::many_producers() {
+		constexpr auto producer_count = 4;
+		constexpr auto per_producer = 10000;
+
+		auto test = queued_event<int>{ 64, overflow_policy::block };
+
+		auto sum = std::int64_t{ 0 };
+		auto count = 0;
+		auto l = test.subscribe([&](int i) { sum += i; count++; });
+
+		auto producers = std::vector<std::thread>{};
+		for (auto p = 0; p < producer_count; p++) {
+			producers.emplace_back([&test]() {
+				for (auto i = 1; i <= per_producer; i++)
+					test(i);
+			});
+		}
+
+		while (count != producer_count * per_producer)
+			test.dispatch_pending();
+
+		for (auto& producer : producers)
+			producer.join();
+
+		Assert::AreEqual<std::int64_t>(std::int64_t{ producer_count } * per_producer * (per_producer + 1) / 2, sum);
+	}
+}
@@ -0,0 +1,98 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#include "pch.h"
+
+#include "static_event.hpp"
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace rpt::static_event_tests {
+
+	TEST_CLASS(static_event_tests) {
+	public:
+		TEST_METHOD(construct);
+
+		TEST_METHOD(dispatch_in_order);
+
+		TEST_METHOD(dispatch_no_copy);
+
+		TEST_METHOD(constexpr_dispatch);
+	};
+
+	struct counter {
+		int* count;
+		void operator()(int i) { *count += i; }
+	};
+
+	struct copy_counter {
+		copy_counter() = default;
+		copy_counter(const copy_counter&) { copies++; }
+
+		static inline int copies = 0;
+	};
+
+	void static_event_tests::construct() {
+		auto test = static_event<std::tuple<>, int>{};
+		test(1);
+
+		auto count = 0;
+		auto one = static_event<std::tuple<counter>, int>{ counter{ &count } };
+		one(2);
+
+		Assert::AreEqual<std::size_t>(1, one.size);
+		Assert::AreEqual(2, count);
+		Assert::IsTrue(one.get<0>().count == &count);
+	}
+
+	void static_event_tests::dispatch_in_order() {
+		auto seen = std::vector<std::string>{};
+		auto test = make_static_event<int, const std::string&>(
+			[&seen](int i, const std::string& s) { seen.push_back("a" + std::to_string(i) + s); },
+			[&seen](int i, const std::string& s) { seen.push_back("b" + std::to_string(i) + s); });
+
+		test(1, "x");
+		test(2, std::string{ "y" });
+
+		Assert::AreEqual<std::size_t>(2, test.size);
+		Assert::AreEqual<std::size_t>(4, seen.size());
+		Assert::AreEqual<std::string>("a1x", seen[0]);
+		Assert::AreEqual<std::string>("b1x", seen[1]);
+		Assert::AreEqual<std::string>("a2y", seen[2]);
+		Assert::AreEqual<std::string>("b2y", seen[3]);
+	}
+
+	void static_event_tests::dispatch_no_copy() {
+		auto test = make_static_event<copy_counter>(
+			[](const copy_counter&) {},
+			[](const copy_counter&) {},
+			[](const copy_counter&) {});
+
+		auto value = copy_counter{};
+		copy_counter::copies = 0;
+		test(value);
+
+		// not trivially copyable, so it goes by reference to every callback.
+		Assert::AreEqual(0, copy_counter::copies);
+	}
+
+	constexpr int constexpr_sum() {
+		auto total = 0;
+		auto test = make_static_event<int>(
+			[&total](int i) { total += i; },
+			[&total](int i) { total += 2 * i; });
+		test(1);
+		test(10);
+		return total;
+	}
+
+	void static_event_tests::constexpr_dispatch() {
+		static_assert(constexpr_sum() == 33);
+		Assert::AreEqual(33, constexpr_sum());
+	}
+}
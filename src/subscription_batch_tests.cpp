@@ -0,0 +1,151 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#include "pch.h"
+
+#include "subscription_batch.hpp"
+
+#include <deque>
+#include <optional>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace rpt::event_tests {
+
+	TEST_CLASS(subscription_batch_tests) {
+	public:
+		TEST_METHOD(construct);
+
+		TEST_METHOD(subscribe_on_commit);
+
+		TEST_METHOD(subscribe_on_destruct);
+
+		TEST_METHOD(unsubscribe_many);
+
+		TEST_METHOD(subscribe_and_unsubscribe);
+
+		TEST_METHOD(unsubscribe_uncommitted);
+	};
+
+	void subscription_batch_tests::construct() {
+		auto test_int = rpt::event<int>{};
+		auto batch = rpt::subscription_batch{ test_int };
+
+		Assert::AreEqual<std::size_t>(0, batch.pending());
+	}
+
+	void subscription_batch_tests::subscribe_on_commit() {
+		auto test_int = rpt::event<int>{};
+		auto test_int_value{ 0 };
+
+		auto callback = [&test_int_value](int i) { test_int_value += i; };
+		auto listeners = std::deque<rpt::listener<decltype(callback), int>>{};
+
+		auto batch = rpt::subscription_batch{ test_int };
+		for (auto i = 0; i < 10; ++i)
+			listeners.emplace_back(batch, callback);
+
+		Assert::AreEqual<std::size_t>(10, batch.pending());
+
+		test_int(1);
+		Assert::AreEqual(0, test_int_value);
+
+		batch.commit();
+
+		Assert::AreEqual<std::size_t>(0, batch.pending());
+
+		test_int(1);
+		Assert::AreEqual(10, test_int_value);
+
+		listeners.clear();
+
+		test_int(1);
+		Assert::AreEqual(10, test_int_value);
+	}
+
+	void subscription_batch_tests::subscribe_on_destruct() {
+		auto test_void = rpt::event{};
+		auto test_void_counter{ 0 };
+
+		auto callback = [&test_void_counter]() { test_void_counter++; };
+		auto listeners = std::deque<rpt::listener<decltype(callback)>>{};
+
+		{
+			auto batch = rpt::subscription_batch{ test_void };
+			listeners.emplace_back(batch, callback);
+			listeners.emplace_back(batch, callback);
+		}
+
+		test_void();
+		Assert::AreEqual(2, test_void_counter);
+	}
+
+	void subscription_batch_tests::unsubscribe_many() {
+		auto test_int = rpt::event<int>{};
+		auto test_int_value{ 0 };
+
+		auto callback = [&test_int_value](int i) { test_int_value += i; };
+		auto listeners = std::deque<rpt::listener<decltype(callback), int>>{};
+		for (auto i = 0; i < 10; ++i)
+			listeners.emplace_back(test_int, callback);
+
+		test_int(1);
+		Assert::AreEqual(10, test_int_value);
+
+		{
+			auto batch = rpt::subscription_batch{ test_int };
+			batch.unsubscribe(std::next(listeners.begin(), 2), listeners.end());
+
+			test_int(1);
+			Assert::AreEqual(20, test_int_value);
+		}
+
+		test_int(1);
+		Assert::AreEqual(22, test_int_value);
+
+		listeners.clear();
+		Assert::IsTrue(test_int_value == 22);
+	}
+
+	void subscription_batch_tests::subscribe_and_unsubscribe() {
+		auto test_int = rpt::event<int>{};
+		auto test_int_value{ 0 };
+
+		auto callback = [&test_int_value](int i) { test_int_value += i; };
+		auto old_listener = std::make_optional<rpt::listener<decltype(callback), int>>(test_int, callback);
+
+		{
+			auto batch = rpt::subscription_batch{ test_int };
+			auto new_listener = batch.subscribe(callback);
+			batch.unsubscribe(*old_listener);
+			batch.commit();
+
+			test_int(2);
+			Assert::AreEqual(2, test_int_value);
+		}
+
+		old_listener.reset();
+
+		test_int(2);
+		Assert::AreEqual(2, test_int_value);
+	}
+
+	void subscription_batch_tests::unsubscribe_uncommitted() {
+		auto test_int = rpt::event<int>{};
+		auto test_int_value{ 0 };
+
+		auto callback = [&test_int_value](int i) { test_int_value += i; };
+
+		auto batch = rpt::subscription_batch{ test_int };
+		auto l = batch.subscribe(callback);
+		batch.unsubscribe(l);
+
+		Assert::AreEqual<std::size_t>(2, batch.pending());
+
+		batch.commit();
+
+		test_int(1);
+		Assert::AreEqual(0, test_int_value);
+	}
+}
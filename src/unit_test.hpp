@@ -0,0 +1,167 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#ifndef RPT_TESTS_UNIT_TEST
+#define RPT_TESTS_UNIT_TEST
+
+#include <cstring>
+#include <cwchar>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+*   Minimal stand in for the MSVC CppUnitTest framework so the test sources
+*   can be built and run with any compiler.
+*
+*   Only the parts of the framework used by the tests are provided.
+*/
+namespace rpt::unit_test {
+
+    struct failure : std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+    struct test_case {
+        const char* class_name;
+        const char* method_name;
+        void(*run)();
+    };
+
+    inline std::vector<test_case>& registry() {
+        static auto cases = std::vector<test_case>{};
+        return cases;
+    }
+
+    struct registration {
+        registration(const char* class_name, const char* method_name, void(*run)()) {
+            registry().push_back({ class_name, method_name, run });
+        }
+    };
+
+    template<typename Class, typename Name>
+    struct test_class {
+        using self_type = Class;
+        static constexpr const char* test_class_name() { return Name::value; }
+    };
+
+    template<typename T, typename = void>
+    struct is_printable : std::false_type {};
+
+    template<typename T>
+    struct is_printable<T, std::void_t<decltype(std::declval<std::ostream&>() << std::declval<const T&>())>>
+        : std::true_type {};
+
+    template<typename T>
+    std::string to_string(const T& value) {
+        if constexpr (std::is_same_v<T, bool>) {
+            return value ? "true" : "false";
+        }
+        else if constexpr (is_printable<T>::value) {
+            auto stream = std::ostringstream{};
+            stream << value;
+            return stream.str();
+        }
+        else {
+            return "<unprintable>";
+        }
+    }
+
+    inline std::string to_string(const wchar_t* message) {
+        auto output = std::string{};
+        if (message == nullptr)
+            return output;
+        while (*message != L'\0')
+            output.push_back(static_cast<char>(*message++));
+        return output;
+    }
+
+    [[noreturn]] inline void fail(const std::string& what, const wchar_t* message, const char* file, int line) {
+        auto stream = std::ostringstream{};
+        stream << file << '(' << line << "): " << what;
+        if (message != nullptr)
+            stream << " - " << to_string(message);
+        throw failure{ stream.str() };
+    }
+
+    int run_all(int argc, char** argv);
+}
+
+namespace Microsoft::VisualStudio::CppUnitTestFramework {
+
+    class Assert {
+    public:
+        static void IsTrue(bool condition, const wchar_t* message = nullptr,
+            const char* file = __builtin_FILE(), int line = __builtin_LINE()) {
+            if (!condition)
+                rpt::unit_test::fail("Assert::IsTrue failed", message, file, line);
+        }
+
+        static void IsFalse(bool condition, const wchar_t* message = nullptr,
+            const char* file = __builtin_FILE(), int line = __builtin_LINE()) {
+            if (condition)
+                rpt::unit_test::fail("Assert::IsFalse failed", message, file, line);
+        }
+
+        template<typename T>
+        static void AreEqual(const T& expected, const T& actual, const wchar_t* message = nullptr,
+            const char* file = __builtin_FILE(), int line = __builtin_LINE()) {
+            if (!(expected == actual))
+                rpt::unit_test::fail("Assert::AreEqual failed, expected <" + rpt::unit_test::to_string(expected)
+                    + "> actual <" + rpt::unit_test::to_string(actual) + ">", message, file, line);
+        }
+
+        static void AreEqual(const char* expected, const char* actual, const wchar_t* message = nullptr,
+            const char* file = __builtin_FILE(), int line = __builtin_LINE()) {
+            AreEqual(std::string{ expected }, std::string{ actual }, message, file, line);
+        }
+
+        template<typename T>
+        static void AreNotEqual(const T& not_expected, const T& actual, const wchar_t* message = nullptr,
+            const char* file = __builtin_FILE(), int line = __builtin_LINE()) {
+            if (not_expected == actual)
+                rpt::unit_test::fail("Assert::AreNotEqual failed, both <" + rpt::unit_test::to_string(actual)
+                    + ">", message, file, line);
+        }
+
+        template<typename T>
+        static void IsNull(const T* ptr, const wchar_t* message = nullptr,
+            const char* file = __builtin_FILE(), int line = __builtin_LINE()) {
+            if (ptr != nullptr)
+                rpt::unit_test::fail("Assert::IsNull failed", message, file, line);
+        }
+
+        template<typename T>
+        static void IsNotNull(const T* ptr, const wchar_t* message = nullptr,
+            const char* file = __builtin_FILE(), int line = __builtin_LINE()) {
+            if (ptr == nullptr)
+                rpt::unit_test::fail("Assert::IsNotNull failed", message, file, line);
+        }
+
+        [[noreturn]] static void Fail(const wchar_t* message = nullptr,
+            const char* file = __builtin_FILE(), int line = __builtin_LINE()) {
+            rpt::unit_test::fail("Assert::Fail", message, file, line);
+        }
+    };
+}
+
+#define TEST_CLASS(className)                                                          \
+    struct className##_test_class_name { static constexpr const char* value = #className; }; \
+    class className : public ::rpt::unit_test::test_class<className, className##_test_class_name>
+
+/*
+*   The registration calls the method through a template so that the body is only
+*   instantiated once the test class is complete.
+*/
+#define TEST_METHOD(methodName)                                                        \
+    template<typename Self = self_type>                                                \
+    static void methodName##_test_run() { Self{}.methodName(); }                       \
+    static inline const ::rpt::unit_test::registration methodName##_test_registration{ \
+        test_class_name(), #methodName, &methodName##_test_run<> };                    \
+    void methodName()
+
+#endif // RPT_TESTS_UNIT_TEST
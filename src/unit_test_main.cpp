@@ -0,0 +1,71 @@
+// This is a part of the RPT (Realy Poor Tech) Framework.
+// Copyright (C) Elizabeth Williams
+// All rights reserved.
+
+#include "unit_test.hpp"
+
+#include <chrono>
+#include <iostream>
+
+namespace rpt::unit_test {
+
+    namespace {
+        bool matches(const test_case& test, int argc, char** argv) {
+            if (argc <= 1)
+                return true;
+
+            auto name = std::string{ test.class_name } + "::" + test.method_name;
+            for (auto i = 1; i < argc; ++i) {
+                if (name.find(argv[i]) != std::string::npos)
+                    return true;
+            }
+            return false;
+        }
+    }
+
+    int run_all(int argc, char** argv) {
+        auto passed = 0;
+        auto failed = std::vector<std::string>{};
+
+        for (const auto& test : registry()) {
+            if (!matches(test, argc, argv))
+                continue;
+
+            auto name = std::string{ test.class_name } + "::" + test.method_name;
+            std::cout << "[ RUN    ] " << name << std::endl;
+
+            auto start = std::chrono::steady_clock::now();
+            auto error = std::string{};
+            try {
+                test.run();
+            }
+            catch (const std::exception& e) {
+                error = e.what();
+            }
+            catch (...) {
+                error = "unknown exception";
+            }
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+            if (error.empty()) {
+                passed++;
+                std::cout << "[     OK ] " << name << " (" << elapsed.count() << " ms)" << std::endl;
+            }
+            else {
+                failed.push_back(name);
+                std::cout << error << '\n'
+                          << "[ FAILED ] " << name << " (" << elapsed.count() << " ms)" << std::endl;
+            }
+        }
+
+        std::cout << passed << " passed, " << failed.size() << " failed" << std::endl;
+        for (const auto& name : failed)
+            std::cout << "  " << name << '\n';
+
+        return failed.empty() ? 0 : 1;
+    }
+}
+
+int main(int argc, char** argv) {
+    return rpt::unit_test::run_all(argc, argv);
+}
@@ -6,8 +6,81 @@
 
 #include "detail/waitable_atomic.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
 namespace rpt::event_detail_tests {
-    
-}
\ No newline at end of file
+
+	using rpt::event_detail::waitable_atomic;
+
+	TEST_CLASS(waitable_atomic_tests) {
+	public:
+		TEST_METHOD(construct);
+
+		TEST_METHOD(increment);
+
+		TEST_METHOD(wait_changed);
+
+		TEST_METHOD(notify_no_waiters);
+
+		TEST_METHOD(wait_notify);
+	};
+
+	void waitable_atomic_tests::construct() {
+		auto test = waitable_atomic<std::uint64_t>{ 3 };
+
+		Assert::AreEqual<std::uint64_t>(3, test.load());
+	}
+
+	void waitable_atomic_tests::increment() {
+		auto test = waitable_atomic<std::uint64_t>{ 0 };
+
+		Assert::AreEqual<std::uint64_t>(0, test++);
+		Assert::AreEqual<std::uint64_t>(1, test++);
+		Assert::AreEqual<std::uint64_t>(2, test--);
+		Assert::AreEqual<std::uint64_t>(1, test.load());
+	}
+
+	void waitable_atomic_tests::wait_changed() {
+		auto test = waitable_atomic<std::uint64_t>{ 1 };
+
+		// returns straight away when the value is already different.
+		test.wait(0);
+	}
+
+	void waitable_atomic_tests::notify_no_waiters() {
+		auto test = waitable_atomic<std::uint64_t>{ 0 };
+
+		test++;
+		test.notify_all();
+
+		Assert::AreEqual<std::uint64_t>(1, test.load());
+	}
+
+	void waitable_atomic_tests::wait_notify() {
+		auto test = waitable_atomic<std::uint64_t>{ 0 };
+		auto released = std::atomic<bool>{ false };
+
+		// the sleep only makes it likely the wait blocks, the check is on ordering.
+		auto thread = std::thread([&]() {
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+			released = true;
+			test.store(1);
+			test.notify_all();
+		});
+
+		test.wait(0);
+
+		// the wait can only have returned once the store it was waiting for happened.
+		auto seen_released = released.load();
+
+		thread.join();
+
+		Assert::AreEqual<std::uint64_t>(1, test.load());
+		Assert::IsTrue(seen_released);
+	}
+}